@@ -38,23 +38,22 @@ void CANbeSerial::setTxPaddingEnable(bool enabled, char value)
 void CANbeSerial::receive(QByteArray data)
 {
     QByteArrayList frames = _cobs.streamDecode(data);
+    QList<uint16_t> crc = QuCLib::Crc::crc16(frames);
 
-    QByteArrayList::iterator i;
-    for (i = frames.begin(); i != frames.end(); ++i)
+    for (qsizetype i = 0; i < frames.size(); i++)
     {
-        _parseMessage(*i);
+        if(crc.at(i) != 0)
+        {
+            _rxErrorCounter++;
+            emit error();
+            continue;
+        }
+        _parseMessage(frames.at(i));
     }
 }
 
 void CANbeSerial::_parseMessage(QByteArray data)
 {
-    if(QuCLib::Crc::crc16(data) != 0)
-    {
-        _rxErrorCounter++;
-        emit error();
-        return;
-    }
-
     PayloadId payloadId = (PayloadId)data.at(0);
     switch(payloadId){
         case  PayloadId::data:
@@ -187,9 +186,9 @@ int8_t CANbeSerial::_dlcToLength(uint8_t dlc)
     else return _dlc[dlc];
 }
 
-int8_t CANbeSerial::_lengthToDlc(uint8_t length)
+int8_t CANbeSerial::_lengthToDlc(qsizetype length)
 {
-    if(length > 64) return -1;
+    if(length < 0 || length > 64) return -1;
     if(length <= 8) return length;
 
     for(uint8_t i = 8; i < sizeof(_dlc); i++)
@@ -200,3 +199,299 @@ int8_t CANbeSerial::_lengthToDlc(uint8_t length)
     return -1;
 }
 
+
+#define CAN_CRC15_POLYNOM 0x4599
+#define CAN_CRC17_POLYNOM 0x3685B
+#define CAN_CRC21_POLYNOM 0x302899
+
+// Unstuffed bits of a frame from SOF to the end of the data field, MSB first
+struct CANbeSerial::FrameBits
+{
+    uint8_t data[80] = {};
+    uint32_t count = 0;
+    uint32_t dataPhaseStart = 0; // first bit after BRS
+    uint8_t dataLength = 0;
+
+    void append(uint32_t value, uint8_t length)
+    {
+        for(int8_t i = length-1; i >= 0; i--, count++)
+        {
+            if((value >> i) & 1) data[count >> 3] |= 0x80 >> (count & 7);
+        }
+    }
+
+    void appendByte(uint8_t value)
+    {
+        uint8_t shift = count & 7;
+        data[count >> 3] |= value >> shift;
+        if(shift) data[(count >> 3) + 1] |= value << (8 - shift);
+        count += 8;
+    }
+
+    bool at(uint32_t index) const
+    {
+        return (data[index >> 3] >> (7 - (index & 7))) & 1;
+    }
+};
+
+namespace {
+// Bit stuffing state: the last bit on the bus and the length of its run (0-5), packed as lastBit<<3 | run
+uint8_t stuffStep(uint8_t &state, bool bit)
+{
+    bool lastBit = state >> 3;
+    uint8_t run = state & 0x07;
+
+    if(bit == lastBit) run++;
+    else run = 1;
+
+    if(run == 5) // a complementary stuff bit is inserted, it starts a new run
+    {
+        state = (!bit) << 3 | 1;
+        return 1;
+    }
+    state = bit << 3 | run;
+    return 0;
+}
+
+// Stuff bits and next state for every state and byte, so a frame is counted a byte at a time
+class StuffTable
+{
+public:
+    StuffTable()
+    {
+        for(uint8_t state = 0; state < 16; state++)
+        {
+            for(uint16_t byte = 0; byte < 256; byte++)
+            {
+                uint8_t nextState = state;
+                uint8_t count = 0;
+                for(int8_t i = 7; i >= 0; i--)
+                {
+                    count += stuffStep(nextState, (byte >> i) & 1);
+                }
+                entry[state][byte] = count << 4 | nextState;
+            }
+        }
+    }
+
+    uint8_t entry[16][256];
+};
+
+const StuffTable &stuffTable()
+{
+    static const StuffTable table;
+    return table;
+}
+
+class Crc15Table
+{
+public:
+    Crc15Table()
+    {
+        for(uint16_t byte = 0; byte < 256; byte++)
+        {
+            uint16_t crc = byte << 7;
+            for(uint8_t i = 0; i < 8; i++)
+            {
+                if(crc & 0x4000) crc = (crc << 1) ^ CAN_CRC15_POLYNOM;
+                else crc = (crc << 1);
+            }
+            entry[byte] = crc & 0x7FFF;
+        }
+    }
+
+    uint16_t entry[256];
+};
+
+const Crc15Table &crc15Table()
+{
+    static const Crc15Table table;
+    return table;
+}
+
+uint32_t crcAddBit(uint32_t crc, bool bit, uint8_t width, uint32_t polynom)
+{
+    bool next = bit ^ ((crc >> (width-1)) & 1);
+    crc = (crc << 1) & ((1 << width) - 1);
+    if(next) crc ^= polynom & ((1 << width) - 1);
+    return crc;
+}
+
+uint32_t stuffBitCount(const uint8_t *data, uint32_t begin, uint32_t end, uint8_t &state)
+{
+    uint32_t count = 0;
+    uint32_t i = begin;
+    for(; i < end && (i & 7); i++)
+    {
+        count += stuffStep(state, (data[i >> 3] >> (7 - (i & 7))) & 1);
+    }
+    for(; i + 8 <= end; i += 8)
+    {
+        uint8_t entry = stuffTable().entry[state][data[i >> 3]];
+        count += entry >> 4;
+        state = entry & 0x0F;
+    }
+    for(; i < end; i++)
+    {
+        count += stuffStep(state, (data[i >> 3] >> (7 - (i & 7))) & 1);
+    }
+    return count;
+}
+}
+
+void CANbeSerial::_frameBits(const CanBusFrame &frame, char paddingValue, FrameBits &bits)
+{
+    int8_t dlc = _lengthToDlc(frame.data.size());
+    if(dlc < 0) return;
+    if(!frame.fd && dlc > 8) dlc = 8;
+
+    bits.append(0, 1); // SOF
+    if(frame.extended)
+    {
+        bits.append(frame.identifier >> 18, 11);
+        bits.append(1, 1); // SRR
+        bits.append(1, 1); // IDE
+        bits.append(frame.identifier, 18);
+    }
+    else
+    {
+        bits.append(frame.identifier, 11);
+    }
+
+    if(frame.fd)
+    {
+        bits.append(0, 1); // RRS
+        if(!frame.extended) bits.append(0, 1); // IDE
+        bits.append(1, 1); // FDF
+        bits.append(0, 1); // res
+        bits.append(frame.bitRateSwitch, 1);
+        bits.dataPhaseStart = bits.count;
+        bits.append(0, 1); // ESI
+        bits.dataLength = _dlcToLength(dlc);
+    }
+    else
+    {
+        bits.append(frame.rtr, 1);
+        if(!frame.extended) bits.append(0, 1); // IDE
+        else bits.append(0, 1); // r1
+        bits.append(0, 1); // r0
+        bits.dataLength = frame.rtr ? 0 : dlc;
+    }
+    bits.append(dlc, 4);
+
+    for(uint8_t i = 0; i < bits.dataLength; i++)
+    {
+        bits.appendByte(i < frame.data.size() ? frame.data.at(i) : paddingValue);
+    }
+}
+
+uint32_t CANbeSerial::frameCrc(const CanBusFrame &frame, char paddingValue)
+{
+    FrameBits bits;
+    _frameBits(frame, paddingValue, bits);
+    if(!bits.count) return 0;
+
+    if(!frame.fd)
+    {
+        uint16_t crc = 0;
+        uint32_t i = 0;
+        for(; i + 8 <= bits.count; i += 8)
+        {
+            crc = ((crc << 8) ^ crc15Table().entry[((crc >> 7) ^ bits.data[i >> 3]) & 0xFF]) & 0x7FFF;
+        }
+        for(; i < bits.count; i++)
+        {
+            crc = crcAddBit(crc, bits.at(i), 15, CAN_CRC15_POLYNOM);
+        }
+        return crc;
+    }
+
+    // CAN FD includes the dynamic stuff bits and the stuff count in the CRC
+    uint8_t width = bits.dataLength > 16 ? 21 : 17;
+    uint32_t polynom = bits.dataLength > 16 ? CAN_CRC21_POLYNOM : CAN_CRC17_POLYNOM;
+    uint32_t crc = 1 << (width-1);
+
+    uint8_t state = 1 << 3; // idle bus is recessive
+    uint32_t stuffCount = 0;
+    for(uint32_t i = 0; i < bits.count; i++)
+    {
+        crc = crcAddBit(crc, bits.at(i), width, polynom);
+        if(stuffStep(state, bits.at(i)) && i+1 < bits.count) // a stuff bit after the last data bit is replaced by the fixed stuff bit
+        {
+            crc = crcAddBit(crc, !bits.at(i), width, polynom);
+            stuffCount++;
+        }
+    }
+
+    static const uint8_t grayCode[8] = {0, 1, 3, 2, 6, 7, 5, 4};
+    uint8_t gray = grayCode[stuffCount & 0x07];
+    uint8_t parity = ((gray >> 2) ^ (gray >> 1) ^ gray) & 1;
+    for(int8_t i = 2; i >= 0; i--) crc = crcAddBit(crc, (gray >> i) & 1, width, polynom);
+    crc = crcAddBit(crc, parity, width, polynom);
+
+    return crc;
+}
+
+CanFrameTiming CANbeSerial::frameTiming(const CanBusFrame &frame) const
+{
+    return frameTiming(frame, _baudrate, _fdBaudrate, _txPaddingValue);
+}
+
+CanFrameTiming CANbeSerial::frameTiming(const CanBusFrame &frame, Baudrate baudrate, Baudrate dataBaudrate, char paddingValue)
+{
+    CanFrameTiming timing = {0, 0, 0, 0};
+
+    FrameBits bits;
+    _frameBits(frame, paddingValue, bits);
+    if(!bits.count) return timing;
+
+    const uint32_t trailerBitCount = 1 + 2 + 7 + 3; // CRC delimiter, ACK slot and delimiter, EOF, intermission
+    uint8_t state = 1 << 3; // idle bus is recessive
+
+    if(!frame.fd)
+    {
+        // Stuffing covers the CRC, so its value changes the frame length
+        bits.append(frameCrc(frame, paddingValue), 15);
+        timing.stuffBitCount = stuffBitCount(bits.data, 0, bits.count, state);
+        timing.bitCount = bits.count + timing.stuffBitCount + trailerBitCount;
+    }
+    else
+    {
+        // The stuff count and CRC field use a fixed stuff bit every four bits, independent of the CRC value
+        uint8_t crcLength = bits.dataLength > 16 ? 21 : 17;
+        uint8_t fixedStuffBitCount = bits.dataLength > 16 ? 7 : 6;
+
+        uint32_t arbitrationStuffBitCount = stuffBitCount(bits.data, 0, bits.dataPhaseStart, state);
+        uint32_t dataStuffBitCount = stuffBitCount(bits.data, bits.dataPhaseStart, bits.count, state);
+        if((state >> 3) != bits.at(bits.count-1)) dataStuffBitCount--; // replaced by the fixed stuff bit
+
+        uint32_t dataPhaseBitCount = bits.count - bits.dataPhaseStart + dataStuffBitCount + 4 + crcLength + fixedStuffBitCount;
+
+        timing.stuffBitCount = arbitrationStuffBitCount + dataStuffBitCount + fixedStuffBitCount;
+        timing.bitCount = bits.dataPhaseStart + arbitrationStuffBitCount + dataPhaseBitCount + trailerBitCount;
+        if(frame.bitRateSwitch) timing.dataBitCount = dataPhaseBitCount;
+    }
+
+    uint64_t nominalBitCount = timing.bitCount - timing.dataBitCount;
+    timing.duration = (uint32_t)(nominalBitCount * 1000000000 / baudrateToBitsPerSecond(baudrate) +
+                                 (uint64_t)timing.dataBitCount * 1000000000 / baudrateToBitsPerSecond(dataBaudrate));
+    return timing;
+}
+
+uint32_t CANbeSerial::baudrateToBitsPerSecond(Baudrate baudrate)
+{
+    switch(baudrate){
+        case Baud10k: return 10000;
+        case Baud20k: return 20000;
+        case Baud50k: return 50000;
+        case Baud100k: return 100000;
+        case Baud125k: return 125000;
+        case Baud250k: return 250000;
+        case Baud500k: return 500000;
+        case Baud1M: return 1000000;
+        case Baud2M: return 2000000;
+        case Baud5M: return 5000000;
+        case Baud10M: return 10000000;
+    }
+    return 125000;
+}
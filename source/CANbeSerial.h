@@ -17,6 +17,14 @@ struct CanBusFrame
     QByteArray data;
 };
 
+struct CanFrameTiming
+{
+    uint32_t bitCount;      // SOF to end of intermission, including stuff bits
+    uint32_t stuffBitCount; // dynamic and fixed stuff bits
+    uint32_t dataBitCount;  // bits transmitted at the data baudrate, part of bitCount
+    uint32_t duration;      // in nanoseconds
+};
+
 
 class CANbeSerial : public QObject
 {
@@ -48,6 +56,14 @@ public:
 
     void setTxPaddingEnable(bool enabled, char value = 0x00);
 
+    // On-wire length of a frame at the configured baudrates. FD frames are padded to the next DLC size with the tx padding value.
+    // A frame with more than 64 data bytes can't be sent, its timing and CRC are 0.
+    CanFrameTiming frameTiming(const CanBusFrame &frame) const;
+    static CanFrameTiming frameTiming(const CanBusFrame &frame, Baudrate baudrate, Baudrate dataBaudrate, char paddingValue = 0x00);
+    // CRC-15 for classic frames, CRC-17 or CRC-21 for FD frames
+    static uint32_t frameCrc(const CanBusFrame &frame, char paddingValue = 0x00);
+    static uint32_t baudrateToBitsPerSecond(Baudrate baudrate);
+
     enum PayloadId:uint8_t {
         data = 0x00,
         errorFrame = 0x01,
@@ -85,8 +101,11 @@ private:
     CanBusFrame _decodeFrame(QByteArray data);
     QByteArray _encodeFrame(CanBusFrame &frame);
 
-    int8_t _dlcToLength(uint8_t dlc);
-    int8_t _lengthToDlc(uint8_t length);
+    static int8_t _dlcToLength(uint8_t dlc);
+    static int8_t _lengthToDlc(qsizetype length);
+
+    struct FrameBits;
+    static void _frameBits(const CanBusFrame &frame, char paddingValue, FrameBits &bits);
 
     Baudrate _baudrate = Baudrate::Baud125k;
     Baudrate _fdBaudrate = Baudrate::Baud125k;
@@ -0,0 +1,197 @@
+#include "checksum.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CHECKSUM_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define CHECKSUM_TARGET
+#else
+#define CHECKSUM_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace QuCLib;
+
+#define ADLER32_MODULUS 65521
+#define FLETCHER16_MODULUS 255
+#define BLOCK_SIZE 4096 // bytes summed before the modulo is applied, keeps the sums within 32 bits
+
+namespace {
+// Sum of the bytes and sum of the bytes weighted by their distance to the block end (size - index)
+void blockSumsScalar(const uint8_t *data, qsizetype size, uint32_t &sum, uint32_t &weightedSum)
+{
+    sum = 0;
+    weightedSum = 0;
+    for(qsizetype i = 0; i < size; i++)
+    {
+        sum += data[i];
+        weightedSum += sum;
+    }
+}
+
+#ifdef CHECKSUM_AVX2
+bool avx2Available()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    static const bool available = []{
+        int info[4];
+        __cpuid(info, 1);
+        if(!(info[2] & (1 << 27)) || (_xgetbv(0) & 6) != 6) return false; // OS saves the AVX registers
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+#else
+    static const bool available = __builtin_cpu_supports("avx2");
+#endif
+    return available;
+}
+
+CHECKSUM_TARGET uint64_t horizontalSum64(__m256i vector)
+{
+    __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(vector), _mm256_extracti128_si256(vector, 1));
+    return (uint64_t)_mm_cvtsi128_si64(sum) + (uint64_t)_mm_extract_epi64(sum, 1);
+}
+
+CHECKSUM_TARGET uint64_t sumAvx2(const uint8_t *data, qsizetype size)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sum = zero;
+    for(; size >= 32; size -= 32, data += 32)
+    {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(bytes, zero));
+    }
+
+    uint64_t output = horizontalSum64(sum);
+    for(; size; size--, data++)
+    {
+        output += *data;
+    }
+    return output;
+}
+
+// size has to be a multiple of 32
+CHECKSUM_TARGET void blockSumsAvx2(const uint8_t *data, qsizetype size, uint32_t &sum, uint32_t &weightedSum)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+                                             16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+
+    __m256i byteSum = zero; // sum of all previous vectors
+    __m256i previousSum = zero; // sum of byteSum before each vector, each counts 32 times for the vectors after it
+    __m256i vectorWeightedSum = zero; // weighted sums within each vector
+
+    for(; size; size -= 32, data += 32)
+    {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        previousSum = _mm256_add_epi64(previousSum, byteSum);
+        byteSum = _mm256_add_epi64(byteSum, _mm256_sad_epu8(bytes, zero));
+        vectorWeightedSum = _mm256_add_epi32(vectorWeightedSum, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, weights), ones));
+    }
+
+    __m256i weighted64 = _mm256_add_epi64(_mm256_unpacklo_epi32(vectorWeightedSum, zero), _mm256_unpackhi_epi32(vectorWeightedSum, zero));
+    sum = (uint32_t)horizontalSum64(byteSum);
+    weightedSum = (uint32_t)(32*horizontalSum64(previousSum) + horizontalSum64(weighted64));
+}
+#endif
+}
+
+uint64_t Checksum::_sum(const uint8_t *data, qsizetype size)
+{
+#ifdef CHECKSUM_AVX2
+    if(avx2Available()) return sumAvx2(data, size);
+#endif
+    uint64_t output = 0;
+    for(qsizetype i = 0; i < size; i++)
+    {
+        output += data[i];
+    }
+    return output;
+}
+
+void Checksum::_runningSums(uint32_t &sum1, uint32_t &sum2, uint32_t modulus, const uint8_t *data, qsizetype size)
+{
+    // For a block of n bytes: sum1 += sum, sum2 += n*sum1 + weightedSum. The modulo is only taken once per block.
+    while(size)
+    {
+        qsizetype blockSize = std::min<qsizetype>(size, BLOCK_SIZE);
+        uint32_t sum;
+        uint32_t weightedSum;
+
+#ifdef CHECKSUM_AVX2
+        if(avx2Available() && blockSize >= 32)
+        {
+            blockSize &= ~(qsizetype)31;
+            blockSumsAvx2(data, blockSize, sum, weightedSum);
+        }
+        else
+#endif
+        {
+            blockSumsScalar(data, blockSize, sum, weightedSum);
+        }
+
+        sum2 = (uint32_t)((sum2 + (uint64_t)blockSize*sum1 + weightedSum) % modulus);
+        sum1 = (sum1 + sum) % modulus;
+
+        data += blockSize;
+        size -= blockSize;
+    }
+}
+
+uint8_t Checksum::sum8(QByteArrayView data)
+{
+    return (uint8_t)_sum(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+uint16_t Checksum::sum16(QByteArrayView data)
+{
+    return (uint16_t)_sum(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+uint32_t Checksum::sum32(QByteArrayView data)
+{
+    return (uint32_t)_sum(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+uint8_t Checksum::sum8_addData(uint8_t sum, QByteArrayView data)
+{
+    return sum + sum8(data);
+}
+
+uint16_t Checksum::sum16_addData(uint16_t sum, QByteArrayView data)
+{
+    return sum + sum16(data);
+}
+
+uint32_t Checksum::sum32_addData(uint32_t sum, QByteArrayView data)
+{
+    return sum + sum32(data);
+}
+
+uint16_t Checksum::fletcher16(QByteArrayView data)
+{
+    return fletcher16_addData(fletcher16_initValue, data);
+}
+
+uint16_t Checksum::fletcher16_addData(uint16_t checksum, QByteArrayView data)
+{
+    uint32_t sum1 = checksum & 0xFF;
+    uint32_t sum2 = checksum >> 8;
+    _runningSums(sum1, sum2, FLETCHER16_MODULUS, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+    return (uint16_t)(sum2 << 8 | sum1);
+}
+
+uint32_t Checksum::adler32(QByteArrayView data)
+{
+    return adler32_addData(adler32_initValue, data);
+}
+
+uint32_t Checksum::adler32_addData(uint32_t checksum, QByteArrayView data)
+{
+    uint32_t sum1 = checksum & 0xFFFF;
+    uint32_t sum2 = checksum >> 16;
+    _runningSums(sum1, sum2, ADLER32_MODULUS, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+    return sum2 << 16 | sum1;
+}
@@ -0,0 +1,37 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+namespace QuCLib {
+
+class Checksum
+{
+
+public:
+    // Sum of all bytes, truncated to the result size
+    static uint8_t sum8(QByteArrayView data);
+    static uint16_t sum16(QByteArrayView data);
+    static uint32_t sum32(QByteArrayView data);
+    static uint8_t sum8_addData(uint8_t sum, QByteArrayView data);
+    static uint16_t sum16_addData(uint16_t sum, QByteArrayView data);
+    static uint32_t sum32_addData(uint32_t sum, QByteArrayView data);
+
+    // Streaming interface, start with the initValue and chain the returned value
+    static uint16_t fletcher16(QByteArrayView data);
+    static constexpr uint16_t fletcher16_initValue = 0x0000;
+    static uint16_t fletcher16_addData(uint16_t checksum, QByteArrayView data);
+
+    static uint32_t adler32(QByteArrayView data);
+    static constexpr uint32_t adler32_initValue = 0x00000001;
+    static uint32_t adler32_addData(uint32_t checksum, QByteArrayView data);
+
+private:
+    static uint64_t _sum(const uint8_t *data, qsizetype size);
+    // Two running sums modulo modulus, as used by Fletcher and Adler
+    static void _runningSums(uint32_t &sum1, uint32_t &sum2, uint32_t modulus, const uint8_t *data, qsizetype size);
+};
+
+};
+#endif //  CHECKSUM_H
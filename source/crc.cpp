@@ -1,9 +1,63 @@
 #include "crc.h"
+#include <cstring>
+#include <atomic>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CRC32C_HARDWARE
+#include <nmmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define CRC32C_TARGET
+#else
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#endif
+#endif
+
 using namespace QuCLib;
 
-#define CRC16_polynom 0x1021  // CCITT
 #define CRC16_INIT_VALUE 0xFFFF
 
+//Poly = 0x1021
+static const uint16_t crc16Table[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
 uint16_t Crc::crc16(QByteArray data)
 {
     uint16_t CRC_value = CRC16_INIT_VALUE;
@@ -16,18 +70,68 @@ uint16_t Crc::crc16(QByteArray data)
 
 uint16_t Crc::crc16_addByte(uint16_t CRC_value, uint8_t data)
 {
-    uint16_t byte = ((uint16_t)data)<<8;
-
-    CRC_value = (CRC_value^byte);
+    return (CRC_value << 8) ^ crc16Table[(CRC_value >> 8) ^ data];
+}
 
-    for(uint8_t j= 0;j<8;j++)
+QList<uint16_t> Crc::crc16(const QByteArrayList &data)
+{
+    QList<QByteArrayView> view;
+    view.reserve(data.size());
+    for(const QByteArray &buffer: data)
     {
-        if(CRC_value & 0x8000) CRC_value = (CRC_value << 1) ^ CRC16_polynom;
-        else CRC_value = (CRC_value << 1);
+        view.append(buffer);
     }
-    return CRC_value;
+
+    QList<uint16_t> output(data.size());
+    crc16(view.constData(), output.data(), view.size());
+    return output;
 }
 
+void Crc::crc16(const QByteArrayView *data, uint16_t *result, qsizetype count)
+{
+    // The table lookup of each byte depends on the previous one. Running four independent
+    // buffers side by side lets the CPU overlap their dependency chains.
+    qsizetype n = 0;
+    for(; n + 4 <= count; n += 4)
+    {
+        const uint8_t *byte0 = reinterpret_cast<const uint8_t*>(data[n].data());
+        const uint8_t *byte1 = reinterpret_cast<const uint8_t*>(data[n+1].data());
+        const uint8_t *byte2 = reinterpret_cast<const uint8_t*>(data[n+2].data());
+        const uint8_t *byte3 = reinterpret_cast<const uint8_t*>(data[n+3].data());
+
+        qsizetype common = std::min(std::min(data[n].size(), data[n+1].size()), std::min(data[n+2].size(), data[n+3].size()));
+
+        uint16_t crc0 = CRC16_INIT_VALUE;
+        uint16_t crc1 = CRC16_INIT_VALUE;
+        uint16_t crc2 = CRC16_INIT_VALUE;
+        uint16_t crc3 = CRC16_INIT_VALUE;
+        for(qsizetype i = 0; i < common; i++)
+        {
+            crc0 = (crc0 << 8) ^ crc16Table[(crc0 >> 8) ^ byte0[i]];
+            crc1 = (crc1 << 8) ^ crc16Table[(crc1 >> 8) ^ byte1[i]];
+            crc2 = (crc2 << 8) ^ crc16Table[(crc2 >> 8) ^ byte2[i]];
+            crc3 = (crc3 << 8) ^ crc16Table[(crc3 >> 8) ^ byte3[i]];
+        }
+
+        for(qsizetype i = common; i < data[n].size(); i++) crc0 = crc16_addByte(crc0, byte0[i]);
+        for(qsizetype i = common; i < data[n+1].size(); i++) crc1 = crc16_addByte(crc1, byte1[i]);
+        for(qsizetype i = common; i < data[n+2].size(); i++) crc2 = crc16_addByte(crc2, byte2[i]);
+        for(qsizetype i = common; i < data[n+3].size(); i++) crc3 = crc16_addByte(crc3, byte3[i]);
+
+        result[n] = crc0;
+        result[n+1] = crc1;
+        result[n+2] = crc2;
+        result[n+3] = crc3;
+    }
+
+    for(; n < count; n++)
+    {
+        const uint8_t *byte = reinterpret_cast<const uint8_t*>(data[n].data());
+        uint16_t crc = CRC16_INIT_VALUE;
+        for(qsizetype i = 0; i < data[n].size(); i++) crc = crc16_addByte(crc, byte[i]);
+        result[n] = crc;
+    }
+}
 
 //Poly =  0x04C11DB7
 static const uint32_t crc32Table[256] = {
@@ -68,11 +172,454 @@ static const uint32_t crc32Table[256] = {
 
 uint32_t Crc::crc32(QByteArray data)
 {
-    uint32_t crc = 0xffffffff;
+    return crc32_addData(crc32_initValue, data);
+}
 
-    for(int32_t i = 0; i < data.size() ; i++)
+uint32_t Crc::crc32_addData(uint32_t crc, QByteArrayView data)
+{
+    const uint8_t *byte = reinterpret_cast<const uint8_t*>(data.data());
+    for(qsizetype i = 0; i < data.size() ; i++)
+    {
+        crc = crc32Table[ (crc ^ byte[i]) & 0xFF ] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+// The CRC register update is linear over GF(2). Advancing the register by 2^k zero bytes is a
+// 32x32 bit matrix, stored as 32 columns. With these powers precomputed, a run of n bytes can be
+// processed in O(log n) matrix-vector multiplications instead of n table lookups.
+namespace {
+class CrcZeroOperator
+{
+public:
+    explicit CrcZeroOperator(const uint32_t *table, bool reflected = true)
+        : _table{table}
+    {
+        for(uint8_t i = 0; i < 32; i++)
+        {
+            uint32_t bit = (uint32_t)1 << i;
+            if(reflected) _power[0][i] = table[bit & 0xFF] ^ (bit >> 8);
+            else _power[0][i] = table[bit >> 24] ^ (bit << 8);
+        }
+        for(uint8_t k = 1; k < 64; k++)
+        {
+            for(uint8_t i = 0; i < 32; i++)
+            {
+                _power[k][i] = _times(_power[k-1], _power[k-1][i]);
+            }
+        }
+    }
+
+    // Advance the register by count zero bytes
+    uint32_t shift(uint32_t crc, uint64_t count) const
+    {
+        for(uint8_t k = 0; count; k++, count >>= 1)
+        {
+            if(count & 1) crc = _times(_power[k], crc);
+        }
+        return crc;
+    }
+
+    // Advance the register by count bytes of value
+    uint32_t fill(uint32_t crc, uint8_t value, uint64_t count) const
+    {
+        uint32_t output = shift(crc, count);
+
+        uint32_t run = _table[value]; // contribution of 2^k value bytes to a zero register
+        uint32_t sum = 0;
+        for(uint8_t k = 0; count; k++, count >>= 1)
+        {
+            if(count & 1) sum = _times(_power[k], sum) ^ run;
+            run = _times(_power[k], run) ^ run;
+        }
+        return output ^ sum;
+    }
+
+private:
+    static uint32_t _times(const uint32_t *matrix, uint32_t vector)
+    {
+        uint32_t output = 0;
+        for(uint8_t i = 0; vector; i++, vector >>= 1)
+        {
+            if(vector & 1) output ^= matrix[i];
+        }
+        return output;
+    }
+
+    const uint32_t *_table;
+    uint32_t _power[64][32];
+};
+
+const CrcZeroOperator &crc32ZeroOperator()
+{
+    static const CrcZeroOperator zeroOperator(crc32Table);
+    return zeroOperator;
+}
+}
+
+uint32_t Crc::crc32_addFill(uint32_t crc, uint8_t value, uint64_t count)
+{
+    return crc32ZeroOperator().fill(crc, value, count);
+}
+
+uint32_t Crc::crc32_combine(uint32_t crcA, uint32_t crcB, uint64_t lengthB)
+{
+    return crc32ZeroOperator().shift(crcA ^ crc32_initValue, lengthB) ^ crcB;
+}
+
+
+#define CRC32C_polynom 0x82F63B78 // Castagnoli, reflected
+
+namespace {
+// Slicing-by-8 tables, table[0] is the regular byte table
+class Crc32cTable
+{
+public:
+    Crc32cTable()
+    {
+        for(uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+            for(uint8_t j = 0; j < 8; j++)
+            {
+                if(crc & 1) crc = (crc >> 1) ^ CRC32C_polynom;
+                else crc = (crc >> 1);
+            }
+            table[0][i] = crc;
+        }
+        for(uint32_t i = 0; i < 256; i++)
+        {
+            for(uint8_t k = 1; k < 8; k++)
+            {
+                table[k][i] = (table[k-1][i] >> 8) ^ table[0][table[k-1][i] & 0xFF];
+            }
+        }
+    }
+
+    uint32_t table[8][256];
+};
+
+const Crc32cTable &crc32cTable()
+{
+    static const Crc32cTable table;
+    return table;
+}
+
+const CrcZeroOperator &crc32cZeroOperator()
+{
+    static const CrcZeroOperator zeroOperator(crc32cTable().table[0]);
+    return zeroOperator;
+}
+
+uint32_t crc32cSoftware(uint32_t crc, const uint8_t *data, qsizetype size)
+{
+    const uint32_t (*table)[256] = crc32cTable().table;
+
+    for(; size && ((uintptr_t)data & 7); size--, data++)
+    {
+        crc = table[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+    }
+
+    for(; size >= 8; size -= 8, data += 8)
+    {
+        uint32_t low = crc ^ ((uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24);
+        uint32_t high = (uint32_t)data[4] | (uint32_t)data[5] << 8 | (uint32_t)data[6] << 16 | (uint32_t)data[7] << 24;
+        crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24] ^
+              table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^ table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+    }
+
+    for(; size; size--, data++)
+    {
+        crc = table[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef CRC32C_HARDWARE
+bool crc32cHardwareAvailable()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    static const bool available = []{ int info[4]; __cpuid(info, 1); return (info[2] & (1 << 20)) != 0; }();
+#else
+    static const bool available = __builtin_cpu_supports("sse4.2");
+#endif
+    return available;
+}
+
+CRC32C_TARGET uint32_t crc32cHardware(uint32_t crc, const uint8_t *data, qsizetype size)
+{
+    // The crc32 instruction has a latency of three cycles but a throughput of one per cycle.
+    // Large buffers are split into three streams that are combined afterwards.
+    const qsizetype blockSize = 8192;
+
+    for(; size && ((uintptr_t)data & 7); size--, data++)
+    {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+
+    uint64_t crc0 = crc;
+    while(size >= 3*blockSize)
+    {
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+        const uint64_t *word0 = reinterpret_cast<const uint64_t*>(data);
+        const uint64_t *word1 = reinterpret_cast<const uint64_t*>(data + blockSize);
+        const uint64_t *word2 = reinterpret_cast<const uint64_t*>(data + 2*blockSize);
+        for(qsizetype i = 0; i < blockSize/8; i++)
+        {
+            crc0 = _mm_crc32_u64(crc0, word0[i]);
+            crc1 = _mm_crc32_u64(crc1, word1[i]);
+            crc2 = _mm_crc32_u64(crc2, word2[i]);
+        }
+        crc0 = crc32cZeroOperator().shift((uint32_t)crc0, blockSize) ^ crc1;
+        crc0 = crc32cZeroOperator().shift((uint32_t)crc0, blockSize) ^ crc2;
+
+        data += 3*blockSize;
+        size -= 3*blockSize;
+    }
+
+    for(; size >= 8; size -= 8, data += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        crc0 = _mm_crc32_u64(crc0, word);
+    }
+    crc = (uint32_t)crc0;
+
+    for(; size; size--, data++)
     {
-        crc = crc32Table[ (crc ^ (uint32_t)data.at(i)) & 0xFF ] ^ (crc >> 8);
+        crc = _mm_crc32_u8(crc, *data);
     }
     return crc;
 }
+#endif
+}
+
+uint32_t Crc::crc32c(QByteArrayView data)
+{
+    return crc32c_addData(crc32c_initValue, data);
+}
+
+uint32_t Crc::crc32c_addData(uint32_t crc, QByteArrayView data)
+{
+    const uint8_t *byte = reinterpret_cast<const uint8_t*>(data.data());
+#ifdef CRC32C_HARDWARE
+    if(crc32cHardwareAvailable()) return ~crc32cHardware(~crc, byte, data.size());
+#endif
+    return ~crc32cSoftware(~crc, byte, data.size());
+}
+
+uint32_t Crc::crc32c_addFill(uint32_t crc, uint8_t value, uint64_t count)
+{
+    return ~crc32cZeroOperator().fill(~crc, value, count);
+}
+
+uint32_t Crc::crc32c_combine(uint32_t crcA, uint32_t crcB, uint64_t lengthB)
+{
+    return crc32cZeroOperator().shift(crcA, lengthB) ^ crcB;
+}
+
+
+#define CRC32_MPEG2_polynom 0x04C11DB7 // not reflected
+
+namespace {
+// Table k advances a byte by k further zero bytes, so one word is processed with four lookups
+class Crc32Stm32Table
+{
+public:
+    Crc32Stm32Table()
+    {
+        for(uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i << 24;
+            for(uint8_t j = 0; j < 8; j++)
+            {
+                if(crc & 0x80000000) crc = (crc << 1) ^ CRC32_MPEG2_polynom;
+                else crc = (crc << 1);
+            }
+            table[0][i] = crc;
+        }
+        for(uint32_t i = 0; i < 256; i++)
+        {
+            for(uint8_t k = 1; k < 4; k++)
+            {
+                table[k][i] = (table[k-1][i] << 8) ^ table[0][table[k-1][i] >> 24];
+            }
+        }
+    }
+
+    uint32_t table[4][256];
+};
+
+const Crc32Stm32Table &crc32Stm32Table()
+{
+    static const Crc32Stm32Table table;
+    return table;
+}
+
+const CrcZeroOperator &crc32Stm32ZeroOperator()
+{
+    static const CrcZeroOperator zeroOperator(crc32Stm32Table().table[0], false);
+    return zeroOperator;
+}
+}
+
+uint32_t Crc::crc32Stm32(QByteArrayView data)
+{
+    return crc32Stm32_addData(crc32Stm32_initValue, data);
+}
+
+uint32_t Crc::crc32Stm32_addData(uint32_t crc, QByteArrayView data)
+{
+    const uint32_t (*table)[256] = crc32Stm32Table().table;
+    const uint8_t *byte = reinterpret_cast<const uint8_t*>(data.data());
+    qsizetype size = data.size();
+
+    // The CRC unit reads a little endian word and shifts it in MSB first
+    for(; size >= 4; size -= 4, byte += 4)
+    {
+        crc ^= (uint32_t)byte[0] | (uint32_t)byte[1] << 8 | (uint32_t)byte[2] << 16 | (uint32_t)byte[3] << 24;
+        crc = table[3][crc >> 24] ^ table[2][(crc >> 16) & 0xFF] ^ table[1][(crc >> 8) & 0xFF] ^ table[0][crc & 0xFF];
+    }
+
+    // Remaining bytes are fed like 8-bit writes to the data register
+    for(; size; size--, byte++)
+    {
+        crc = (crc << 8) ^ table[0][(crc >> 24) ^ *byte];
+    }
+    return crc;
+}
+
+uint32_t Crc::crc32Stm32_addFill(uint32_t crc, uint8_t value, uint64_t count)
+{
+    return crc32Stm32ZeroOperator().fill(crc, value, count);
+}
+
+
+#define FILE_MAP_WINDOW_SIZE (256*1024*1024) // multiple of the page size and of 4 for word-fed CRCs
+#define FILE_READ_BLOCK_SIZE (1024*1024)
+
+static std::atomic<qint64> mapWindowSize = FILE_MAP_WINDOW_SIZE;
+
+void Crc::setFileMapWindowSize(qint64 size)
+{
+    mapWindowSize = size > 0 ? size : FILE_MAP_WINDOW_SIZE;
+}
+
+qint64 Crc::fileMapWindowSize()
+{
+    return mapWindowSize;
+}
+
+bool Crc::_processFile(QFile &file, const std::function<void(QByteArrayView)> &process)
+{
+    bool openedHere = false;
+    if(!file.isOpen())
+    {
+        if(!file.open(QIODevice::ReadOnly)) return false;
+        openedHere = true;
+    }
+
+#ifdef Q_OS_LINUX
+    posix_fadvise(file.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    bool ok = true;
+    bool sequential = file.isSequential(); // pipes have no size and can't be mapped
+    qint64 size = sequential ? 0 : file.size();
+    qint64 position = 0;
+    qint64 windowSize = mapWindowSize;
+
+    // Map the file window by window, a 32-bit process can't map a large file at once
+    while(position < size)
+    {
+        qint64 length = std::min<qint64>(size - position, windowSize);
+        uchar *map = file.map(position, length);
+        if(map == nullptr) break;
+
+#ifdef Q_OS_LINUX
+        madvise(map, length, MADV_SEQUENTIAL);
+#endif
+        process(QByteArrayView(map, length));
+        file.unmap(map);
+        position += length;
+    }
+
+    // Fall back to reading blocks if the file system doesn't support mapping, pipes are read until their end
+    if(sequential || (position < size && file.seek(position)))
+    {
+        QByteArray buffer(FILE_READ_BLOCK_SIZE, 0);
+        while(sequential || position < size)
+        {
+            qint64 length = file.read(buffer.data(), buffer.size());
+            if(length < 0) ok = false;
+            if(length <= 0) break;
+
+            process(QByteArrayView(buffer.constData(), length));
+            position += length;
+        }
+    }
+    if(position < size) ok = false;
+
+    if(openedHere) file.close();
+    return ok;
+}
+
+uint16_t Crc::crc16File(QFile &file, bool *ok)
+{
+    uint16_t crc = CRC16_INIT_VALUE;
+    bool success = _processFile(file, [&](QByteArrayView data){
+        const uint8_t *byte = reinterpret_cast<const uint8_t*>(data.data());
+        for(qsizetype i = 0; i < data.size(); i++) crc = crc16_addByte(crc, byte[i]);
+    });
+    if(ok) *ok = success;
+    return crc;
+}
+
+uint32_t Crc::crc32File(QFile &file, bool *ok)
+{
+    uint32_t crc = crc32_initValue;
+    bool success = _processFile(file, [&](QByteArrayView data){ crc = crc32_addData(crc, data); });
+    if(ok) *ok = success;
+    return crc;
+}
+
+uint32_t Crc::crc32cFile(QFile &file, bool *ok)
+{
+    uint32_t crc = crc32c_initValue;
+    bool success = _processFile(file, [&](QByteArrayView data){ crc = crc32c_addData(crc, data); });
+    if(ok) *ok = success;
+    return crc;
+}
+
+uint32_t Crc::crc32Stm32File(QFile &file, bool *ok)
+{
+    uint32_t crc = crc32Stm32_initValue;
+    bool success = _processFile(file, [&](QByteArrayView data){ crc = crc32Stm32_addData(crc, data); });
+    if(ok) *ok = success;
+    return crc;
+}
+
+uint16_t Crc::crc16File(const QString &filePath, bool *ok)
+{
+    QFile file(filePath);
+    return crc16File(file, ok);
+}
+
+uint32_t Crc::crc32File(const QString &filePath, bool *ok)
+{
+    QFile file(filePath);
+    return crc32File(file, ok);
+}
+
+uint32_t Crc::crc32cFile(const QString &filePath, bool *ok)
+{
+    QFile file(filePath);
+    return crc32cFile(file, ok);
+}
+
+uint32_t Crc::crc32Stm32File(const QString &filePath, bool *ok)
+{
+    QFile file(filePath);
+    return crc32Stm32File(file, ok);
+}
@@ -2,6 +2,10 @@
 #define CRC_H
 
 #include <QByteArray>
+#include <QByteArrayView>
+#include <QByteArrayList>
+#include <QFile>
+#include <functional>
 
 namespace QuCLib {
 
@@ -11,8 +15,51 @@ class Crc
 public:
     static uint16_t crc16(QByteArray data);
     static uint16_t crc16_addByte(uint16_t CRC_value, uint8_t data);
+    // One CRC16 per buffer, interleaving several buffers for throughput on many small frames
+    static QList<uint16_t> crc16(const QByteArrayList &data);
+    static void crc16(const QByteArrayView *data, uint16_t *result, qsizetype count);
     static uint32_t crc32(QByteArray data);
+
+    // Streaming interface, start with crc32_initValue and chain the returned value
+    static constexpr uint32_t crc32_initValue = 0xFFFFFFFF;
+    static uint32_t crc32_addData(uint32_t crc, QByteArrayView data);
+    // Adds count bytes of the same value in O(log count), e.g. for unprogrammed flash
+    static uint32_t crc32_addFill(uint32_t crc, uint8_t value, uint64_t count);
+    // CRC of A followed by B, from the CRC of A, the CRC of B and the length of B
+    static uint32_t crc32_combine(uint32_t crcA, uint32_t crcB, uint64_t lengthB);
+
+    // CRC-32C (Castagnoli), uses the SSE4.2 crc32 instruction when the CPU supports it
+    static uint32_t crc32c(QByteArrayView data);
+    static constexpr uint32_t crc32c_initValue = 0x00000000;
+    static uint32_t crc32c_addData(uint32_t crc, QByteArrayView data);
+    static uint32_t crc32c_addFill(uint32_t crc, uint8_t value, uint64_t count);
+    static uint32_t crc32c_combine(uint32_t crcA, uint32_t crcB, uint64_t lengthB);
+
+    // CRC-32/MPEG-2 fed with 32-bit little endian words, as calculated by the STM32 CRC unit.
+    // Trailing bytes that don't fill a word are fed as 8-bit writes.
+    static uint32_t crc32Stm32(QByteArrayView data);
+    static constexpr uint32_t crc32Stm32_initValue = 0xFFFFFFFF;
+    static uint32_t crc32Stm32_addData(uint32_t crc, QByteArrayView data);
+    // count should be a multiple of 4 to stay word aligned
+    static uint32_t crc32Stm32_addFill(uint32_t crc, uint8_t value, uint64_t count);
+
+    // Whole file, memory mapped or read in fixed size blocks, without loading it into one buffer.
+    // Sequential files such as pipes are read until their end.
+    // ok is set to false if the file can't be opened or read.
+    static uint16_t crc16File(QFile &file, bool *ok = nullptr);
+    static uint32_t crc32File(QFile &file, bool *ok = nullptr);
+    static uint32_t crc32cFile(QFile &file, bool *ok = nullptr);
+    static uint32_t crc32Stm32File(QFile &file, bool *ok = nullptr);
+    static uint16_t crc16File(const QString &filePath, bool *ok = nullptr);
+    static uint32_t crc32File(const QString &filePath, bool *ok = nullptr);
+    static uint32_t crc32cFile(const QString &filePath, bool *ok = nullptr);
+    static uint32_t crc32Stm32File(const QString &filePath, bool *ok = nullptr);
+    // Bytes of a file mapped at once, 256 MiB by default. A multiple of the page size, 0 restores the default.
+    static void setFileMapWindowSize(qint64 size);
+    static qint64 fileMapWindowSize(void);
+
 private:
+    static bool _processFile(QFile &file, const std::function<void(QByteArrayView)> &process);
 };
 
 };
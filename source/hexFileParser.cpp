@@ -1,7 +1,301 @@
 #include "hexFileParser.h"
-#include <QTextStream>
+#include "crc.h"
+#include "checksum.h"
+#include <QtEndian>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <cstring>
+#include <cctype>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define HEX_DECODE_SIMD // SSSE3/AVX2 hex decoder, selected at runtime
+#define FILL_CHECK_SIMD // SSE2 blank page check
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define HEX_DECODE_SSSE3_TARGET
+#define HEX_DECODE_AVX2_TARGET
+#else
+#define HEX_DECODE_SSSE3_TARGET __attribute__((target("ssse3")))
+#define HEX_DECODE_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
 using namespace QuCLib;
 
+// Value of an ASCII hex digit, 0x100 for any other character
+static const uint16_t hexDigitTable[256] = {
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x000, 0x001, 0x002, 0x003, 0x004, 0x005, 0x006, 0x007, 0x008, 0x009, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x100, 0x00A, 0x00B, 0x00C, 0x00D, 0x00E, 0x00F, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x100, 0x00A, 0x00B, 0x00C, 0x00D, 0x00E, 0x00F, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100,
+    0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100, 0x100
+};
+
+// Decodes two hex digits, the result is larger than 0xFF if one of them is invalid
+static inline uint16_t decodeHexByte(const char *text)
+{
+    return (hexDigitTable[(uint8_t)text[0]] << 4) | hexDigitTable[(uint8_t)text[1]];
+}
+
+// Hex string to bytes. Each kernel returns the index of the first invalid character or -1 if all are valid.
+namespace {
+qsizetype decodeHexScalar(const char *text, uint8_t *output, qsizetype count)
+{
+    for(qsizetype i = 0; i < count; i++)
+    {
+        uint16_t byte = decodeHexByte(&text[i*2]);
+        if(byte > 0xFF) return hexDigitTable[(uint8_t)text[i*2]] > 0x0F ? i*2 : i*2+1;
+        output[i] = byte;
+    }
+    return -1;
+}
+
+#ifdef HEX_DECODE_SIMD
+inline uint32_t countTrailingZeros(uint32_t value)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return index;
+#else
+    return __builtin_ctz(value);
+#endif
+}
+
+// Digit values of 16 characters and a mask of the invalid characters
+HEX_DECODE_SSSE3_TARGET inline __m128i hexDigitValues(__m128i text, uint32_t &invalidMask)
+{
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(text, _mm_set1_epi8('0'-1)), _mm_cmplt_epi8(text, _mm_set1_epi8('9'+1)));
+    __m128i lower = _mm_or_si128(text, _mm_set1_epi8(0x20));
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a'-1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f'+1)));
+    invalidMask = ~_mm_movemask_epi8(_mm_or_si128(digit, letter)) & 0xFFFF;
+
+    __m128i digitValue = _mm_and_si128(digit, _mm_sub_epi8(text, _mm_set1_epi8('0')));
+    __m128i letterValue = _mm_and_si128(letter, _mm_sub_epi8(lower, _mm_set1_epi8('a'-10)));
+    return _mm_or_si128(digitValue, letterValue);
+}
+
+HEX_DECODE_SSSE3_TARGET qsizetype decodeHexSsse3(const char *text, uint8_t *output, qsizetype count)
+{
+    const __m128i weights = _mm_set1_epi16(0x0110); // high digit * 16 + low digit
+    qsizetype i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        uint32_t invalidMask;
+        __m128i values = hexDigitValues(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&text[i*2])), invalidMask);
+        if(invalidMask) return i*2 + countTrailingZeros(invalidMask);
+
+        __m128i bytes = _mm_maddubs_epi16(values, weights);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&output[i]), _mm_packus_epi16(bytes, bytes));
+    }
+
+    qsizetype invalid = decodeHexScalar(&text[i*2], &output[i], count - i);
+    return invalid < 0 ? -1 : i*2 + invalid;
+}
+
+HEX_DECODE_AVX2_TARGET qsizetype decodeHexAvx2(const char *text, uint8_t *output, qsizetype count)
+{
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    const __m256i zero = _mm256_setzero_si256();
+    qsizetype i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+        __m256i text256 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&text[i*2]));
+        __m256i lower = _mm256_or_si256(text256, _mm256_set1_epi8(0x20));
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(text256, _mm256_set1_epi8('0'-1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9'+1), text256));
+        __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a'-1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('f'+1), lower));
+        uint32_t invalidMask = ~(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(digit, letter));
+        if(invalidMask) return i*2 + countTrailingZeros(invalidMask);
+
+        __m256i values = _mm256_or_si256(_mm256_and_si256(digit, _mm256_sub_epi8(text256, _mm256_set1_epi8('0'))),
+                                         _mm256_and_si256(letter, _mm256_sub_epi8(lower, _mm256_set1_epi8('a'-10))));
+        __m256i bytes = _mm256_packus_epi16(_mm256_maddubs_epi16(values, weights), zero);
+        bytes = _mm256_permute4x64_epi64(bytes, 0x08); // 64-bit lanes 0 and 2 hold the result
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&output[i]), _mm256_castsi256_si128(bytes));
+    }
+
+    qsizetype invalid = decodeHexSsse3(&text[i*2], &output[i], count - i);
+    return invalid < 0 ? -1 : i*2 + invalid;
+}
+#endif
+
+typedef qsizetype (*DecodeHexFunction)(const char *text, uint8_t *output, qsizetype count);
+
+DecodeHexFunction selectDecodeHex()
+{
+#ifdef HEX_DECODE_SIMD
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool ssse3 = info[2] & (1 << 9);
+    bool avx = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    bool avx2 = avx && (info[1] & (1 << 5));
+#else
+    bool ssse3 = __builtin_cpu_supports("ssse3");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if(avx2) return decodeHexAvx2;
+    if(ssse3) return decodeHexSsse3;
+#endif
+    return decodeHexScalar;
+}
+
+const DecodeHexFunction decodeHex = selectDecodeHex();
+
+// True if every byte has the value, e.g. a blank flash page
+bool isFilled(QByteArrayView data, uint8_t value)
+{
+    const char *position = data.data();
+    const char *end = position + data.size();
+#ifdef FILL_CHECK_SIMD
+    // SSE2 is part of x86-64, 64 bytes per step
+    const __m128i pattern = _mm_set1_epi8((char)value);
+    for(; end - position >= 64; position += 64)
+    {
+        __m128i difference = _mm_or_si128(
+            _mm_or_si128(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(position)), pattern),
+                         _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(position + 16)), pattern)),
+            _mm_or_si128(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(position + 32)), pattern),
+                         _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(position + 48)), pattern)));
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(difference, _mm_setzero_si128())) != 0xFFFF) return false;
+    }
+#else
+    const uint64_t pattern = value * 0x0101010101010101ull;
+    for(; end - position >= 8; position += 8)
+    {
+        uint64_t word;
+        memcpy(&word, position, 8);
+        if(word != pattern) return false;
+    }
+#endif
+    for(; position < end; position++)
+    {
+        if((uint8_t)*position != value) return false;
+    }
+    return true;
+}
+
+// Two upper case hex digits for each byte value
+class HexEncodeTable
+{
+public:
+    HexEncodeTable()
+    {
+        const char digits[] = "0123456789ABCDEF";
+        for(uint32_t i = 0; i < 256; i++)
+        {
+            table[i][0] = digits[i >> 4];
+            table[i][1] = digits[i & 0x0F];
+        }
+    }
+
+    char table[256][2];
+};
+
+const HexEncodeTable hexEncodeTable;
+
+inline char *encodeHexByte(char *output, uint8_t byte)
+{
+    memcpy(output, hexEncodeTable.table[byte], 2);
+    return output + 2;
+}
+
+// Encodes one record including the line end, returns the position after it
+char *encodeRecord(char *output, uint8_t recordType, uint16_t address, const uint8_t *data, uint8_t length)
+{
+    uint8_t checksum = length + (address >> 8) + address + recordType;
+    *output++ = ':';
+    output = encodeHexByte(output, length);
+    output = encodeHexByte(output, address >> 8);
+    output = encodeHexByte(output, address);
+    output = encodeHexByte(output, recordType);
+    for(uint8_t i = 0; i < length; i++)
+    {
+        checksum += data[i];
+        output = encodeHexByte(output, data[i]);
+    }
+    output = encodeHexByte(output, 0x100 - checksum);
+    *output++ = '\n';
+    return output;
+}
+
+// Encodes one S-record including the line end, the address is written with addressLength bytes
+char *encodeSRecord(char *output, char recordType, uint32_t address, uint8_t addressLength, const uint8_t *data, uint8_t length)
+{
+    uint8_t byteCount = addressLength + length + 1;
+    uint8_t checksum = byteCount;
+    *output++ = 'S';
+    *output++ = recordType;
+    output = encodeHexByte(output, byteCount);
+    for(int8_t i = addressLength-1; i >= 0; i--)
+    {
+        checksum += (uint8_t)(address >> (i*8));
+        output = encodeHexByte(output, address >> (i*8));
+    }
+    for(uint8_t i = 0; i < length; i++)
+    {
+        checksum += data[i];
+        output = encodeHexByte(output, data[i]);
+    }
+    output = encodeHexByte(output, ~checksum);
+    *output++ = '\n';
+    return output;
+}
+
+#define WRITE_BUFFER_SIZE (1024*1024)
+#define MAX_RECORD_LINE_LENGTH (1+2+4+2+255*2+2+1)
+
+// Collects encoded records in one buffer that is written to the file when it is full
+class RecordWriter
+{
+public:
+    explicit RecordWriter(QFile &file)
+        : _file(file), _buffer(WRITE_BUFFER_SIZE, Qt::Uninitialized), _position(_buffer.data()), _ok(true)
+    {
+    }
+
+    // Space for one record line
+    char *reserve()
+    {
+        if(_position - _buffer.constData() > WRITE_BUFFER_SIZE - MAX_RECORD_LINE_LENGTH) flush();
+        return _position;
+    }
+
+    void commit(char *lineEnd)
+    {
+        _position = lineEnd;
+    }
+
+    bool flush()
+    {
+        qint64 size = _position - _buffer.constData();
+        if(_file.write(_buffer.constData(), size) != size) _ok = false;
+        _position = _buffer.data();
+        return _ok;
+    }
+
+private:
+    QFile &_file;
+    QByteArray _buffer;
+    char *_position;
+    bool _ok;
+};
+}
+
 HexFileParser::HexFileParser(void)
 {
     clear();
@@ -14,7 +308,13 @@ void HexFileParser::clear()
     _addressGapSize = 16;
     _addressAlignment = 1;
     _fillValue = 0xFF;
-    _binary.clear();
+    _image = MemoryImage();
+    _crcCacheEnabled = false;
+    _chunkCrc.clear();
+    _threadCount = 1;
+    _recordLength = 16;
+    _streamTimeout = 30000;
+    _loadCacheEnabled = false;
 }
 
 void HexFileParser::setMemorySize(const Range &range)
@@ -38,6 +338,36 @@ void HexFileParser::setAddressAlignment(uint32_t alignment)
     _addressAlignment = alignment;
 }
 
+void HexFileParser::setImageStorage(MemoryImage::Storage storage)
+{
+    if(_image.storage() == storage) return;
+
+    MemoryImage image(storage);
+    for(const Range &range: _image.ranges())
+    {
+        uint32_t address = range.minimum;
+        _image.walk(range.minimum, range.maximum - range.minimum + 1,
+            [&](QByteArrayView data){ image.write(address, data); address += data.size(); },
+            [](uint64_t){});
+    }
+    _image = image;
+}
+
+void HexFileParser::setThreadCount(uint32_t count)
+{
+    _threadCount = count;
+}
+
+void HexFileParser::setStreamTimeout(int milliseconds)
+{
+    _streamTimeout = milliseconds;
+}
+
+void HexFileParser::setRecordLength(uint8_t length)
+{
+    _recordLength = std::max<uint8_t>(length, 1);
+}
+
 uint32_t HexFileParser::errorCount() const
 {
     return _error.count();
@@ -71,368 +401,1532 @@ QString HexFileParser::errorMessage(const FileError &error)
         case ErrorType::InvalidDataByte: return "Invalid data";
         case ErrorType::AddressRangeTooLow: return "Address out of range (lower minimum address)";
         case ErrorType::AddressRangeTooHigh: return "Address out of range (higher maximum address)";
+        case ErrorType::InvalidFileHeader: return "Invalid file header";
+        case ErrorType::InvalidSegment: return "Segment outside of the file";
+        case ErrorType::Canceled: return "Load canceled";
     }
 
     return "Unknwon Error";
 }
 
-uint8_t HexFileParser::_calculateChecksum(QByteArray data)
-{
-    uint8_t output = 0;
-    foreach(const uint8_t &byte, data){
-        output+= byte;
-    }
-    output = (0xFF-output)+1;
-    return output;
-}
-
 QList<HexFileParser::BinaryChunk> HexFileParser::binary(void) const
 {
-    return _binary;
+    return _image.chunks();
 }
 
 QByteArray HexFileParser::extract(uint32_t address, uint32_t size)
 {
-    QByteArray output;
-    for(const BinaryChunk &data: std::as_const(_binary)){
-        if(data.offset <= address){
-            if(data.data.length() - (address-data.offset) >= size){
-                output = data.data.mid(address-data.offset, size);
-                break;
-            }
-        }
-    }
-    return output;
+    return _image.read(address, size, _fillValue);
 }
 
-void HexFileParser::replace(uint32_t address, QByteArray data)
+QByteArrayView HexFileParser::extractView(uint32_t address, uint32_t size, QByteArray &buffer) const
 {
-    for(uint32_t i = 0; i< _binary.length(); i++)
-    {
-        if(_binary.at(i).offset <= address)
-        {
-            BinaryChunk chunk = _binary.at(i);
-            uint32_t index = address - chunk.offset;
-            if(chunk.data.length() - index >= data.length())
-            {
-                chunk.data.replace(index, data.size(), data);
-                _binary[i] = chunk;
-            }
-        }
-    }
+    return _view(_image, address, size, _fillValue, buffer);
 }
 
-void HexFileParser::insert(const BinaryChunk &data)
+void HexFileParser::extract(uint32_t address, uint32_t size, const std::function<void (QByteArrayView)> &data, const std::function<void (uint64_t)> &fill) const
 {
-    // TODO: Check if chunk is already inside binary
-    // TODO: Check inside address range
-    _binary.append(data);
-    std::sort(_binary.begin(), _binary.end(), [](const BinaryChunk &a, const BinaryChunk &b){ return a.offset < b.offset; } );
+    _image.walk(address, size, data, fill);
 }
 
-const HexFileParser::Range &HexFileParser::fileAddressRange() const
+QByteArrayView HexFileParser::_view(const MemoryImage &image, uint32_t address, uint32_t size, uint8_t fillValue, QByteArray &buffer)
 {
-    return _fileAddress;
+    QByteArrayView view;
+    if(image.view(address, size, view)) return view;
+
+    // resize() keeps the allocation of a buffer that was used before
+    buffer.resize(size);
+    char *output = buffer.data();
+    image.walk(address, size,
+        [&](QByteArrayView data){
+            memcpy(output, data.data(), data.size());
+            output += data.size();
+        },
+        [&](uint64_t count){
+            memset(output, fillValue, count);
+            output += count;
+        });
+    return QByteArrayView(buffer.constData(), size);
 }
 
-const HexFileParser::Range &HexFileParser::binaryAddressRange() const
+HexFileParser::FlashUpdate HexFileParser::diff(const HexFileParser &device, const FlashGeometry &geometry) const
 {
-    return _binaryAddress;
+    return _diff(device._image, geometry);
 }
 
-const HexFileParser::Range &HexFileParser::memoryAddressRange() const
+HexFileParser::FlashUpdate HexFileParser::diff(uint32_t address, const QByteArray &readback, const FlashGeometry &geometry) const
 {
-    return _memorySize;
+    // A chunk that touches nothing shares the data, the readback isn't copied
+    MemoryImage device;
+    device.write(address, readback);
+    return _diff(device, geometry);
 }
 
-bool HexFileParser::load(QString filePath)
+HexFileParser::FlashUpdate HexFileParser::_diff(const MemoryImage &device, const FlashGeometry &geometry) const
 {
-    _error.clear();
-    _binary.clear();
-
-    _high16BitAddress = 0;
-    _fileAddress.minimum = 0xFFFFFFFF;
-    _fileAddress.maximum = 0;
+    FlashUpdate update;
+    QByteArray buffer;
+
+    // Non-blank pages of the current sector, programmed if any page of the sector changed
+    QList<Range> sectorPages;
+    bool sectorChanged = false;
+    auto finishSector = [&](){
+        if(sectorChanged){
+            for(const Range &page: std::as_const(sectorPages)){
+                update.pages.append(BinaryChunk{page.minimum, _image.read(page.minimum, page.maximum - page.minimum + 1, geometry.erasedValue)});
+            }
+        }
+        sectorPages.clear();
+        sectorChanged = false;
+    };
+
+    // Pages with data on the device only are compared too, they need an erase
+    QList<Range> ranges = _image.ranges();
+    ranges.append(device.ranges());
+    std::sort(ranges.begin(), ranges.end(), [](const Range &a, const Range &b){ return a.minimum < b.minimum; });
+    QList<Range> merged;
+    for(const Range &range: std::as_const(ranges)){
+        if(!merged.isEmpty() && range.minimum <= (uint64_t)merged.last().maximum + 1) merged.last().maximum = std::max(merged.last().maximum, range.maximum);
+        else merged.append(range);
+    }
 
-    QString line;
-    QFile hexFile(filePath);
-    hexFile.open(QIODevice::ReadOnly);
+    qsizetype sector = -1;
+    _forEachPage(merged, geometry, [&](const FlashPage &page){
+        if(page.sector != sector){
+            finishSector();
+            sector = page.sector;
+        }
 
-    if(hexFile.isOpen()){
-        uint32_t lineIndex = 0;
-        while(!hexFile.atEnd())
-        {
-            lineIndex++;
-            line = hexFile.readLine();
-            _parseLine(lineIndex, line.trimmed());
+        // memcmp is vectorized by the C library
+        QByteArrayView current = _view(device, page.address, page.data.size(), geometry.erasedValue, buffer);
+        if(memcmp(page.data.data(), current.data(), page.data.size()) != 0){
+            update.changedPages++;
+            if(!sectorChanged) update.sectors.append(sector);
+            sectorChanged = true;
         }
-        hexFile.close();
+        if(!page.blank) sectorPages.append(Range{page.address, (uint32_t)(page.address + page.data.size() - 1)});
+        return true;
+    });
+    finishSector();
 
-        if(_error.count()  > 0) return false;
+    return update;
+}
 
-        _combineBinaryChunks();
-        return true;
-    }else{
-        _error.append(FileError{0,ErrorType::FileNotOpen});
-        return false;
+HexFileParser::FlashGeometry HexFileParser::FlashGeometry::uniform(uint32_t address, uint32_t sectorSize, uint32_t sectorCount, uint32_t pageSize, uint8_t erasedValue)
+{
+    FlashGeometry geometry;
+    geometry.pageSize = pageSize;
+    geometry.erasedValue = erasedValue;
+    for(uint64_t sector = address; sector < (uint64_t)address + (uint64_t)sectorSize*sectorCount && sector <= 0xFFFFFFFF; sector += sectorSize)
+    {
+        geometry.sectors.append(Range{(uint32_t)sector, (uint32_t)std::min<uint64_t>(sector + sectorSize - 1, 0xFFFFFFFF)});
     }
+    return geometry;
 }
 
-bool HexFileParser::saveToFile(QString filePath)
+bool HexFileParser::forEachPage(const FlashGeometry &geometry, const std::function<bool (const FlashPage &)> &page) const
 {
-    QFile hexFile(filePath);
-    if(!hexFile.open(QIODevice::WriteOnly)){
-        return false;
-    }
+    return _forEachPage(_image.ranges(), geometry, page);
+}
 
-    QTextStream out(&hexFile);
+bool HexFileParser::_forEachPage(const QList<Range> &ranges, const FlashGeometry &geometry, const std::function<bool (const FlashPage &)> &page) const
+{
+    if(geometry.pageSize == 0) return true;
 
-    uint16_t offsetPrefix = 0;
-    for(const BinaryChunk &data: std::as_const(_binary))
+    QByteArray buffer(geometry.pageSize, Qt::Uninitialized);
+    qsizetype firstRange = 0;
+    for(qsizetype sector = 0; sector < geometry.sectors.size(); sector++)
     {
-        if(data.offset  > 0xFFFF)
+        const Range &sectorRange = geometry.sectors.at(sector);
+        while(firstRange < ranges.size() && ranges.at(firstRange).maximum < sectorRange.minimum) firstRange++;
+
+        // Pages of the sector that overlap a range, a page that overlaps two ranges is visited once
+        uint64_t nextPage = sectorRange.minimum;
+        for(qsizetype i = firstRange; i < ranges.size() && ranges.at(i).minimum <= sectorRange.maximum; i++)
         {
-            uint16_t offset = (data.offset>>4)&0xFF00;
-            if(offset != offsetPrefix)
+            uint64_t start = std::max(ranges.at(i).minimum, sectorRange.minimum);
+            uint64_t end = std::min(ranges.at(i).maximum, sectorRange.maximum);
+            uint64_t pageAddress = std::max<uint64_t>(nextPage, start - (start - sectorRange.minimum) % geometry.pageSize);
+            for(; pageAddress <= end; pageAddress += geometry.pageSize)
             {
-                offsetPrefix = offset;
-                QByteArray line;
-                line.append((uint8_t)0x02);
-                line.append((uint8_t)0x00);
-                line.append((uint8_t)0x00);
-                line.append((uint8_t)RecordType::ExtendedSegmentAddress);
-                line.append((uint8_t)(offsetPrefix>>8));
-                line.append((uint8_t)offsetPrefix);
-                line.append((uint8_t)_calculateChecksum(line));
-
-                QString lineSting = ":"+line.toHex();
-                out << lineSting.toUpper() << Qt::endl;
+                uint32_t size = std::min<uint64_t>(geometry.pageSize, (uint64_t)sectorRange.maximum - pageAddress + 1);
+                QByteArrayView data = _view(_image, pageAddress, size, geometry.erasedValue, buffer);
+                if(!page(FlashPage{(uint32_t)pageAddress, sector, data, isFilled(data, geometry.erasedValue)})) return false;
             }
+            nextPage = pageAddress;
         }
-
-        uint32_t i;
-        for(i= 0; i< data.data.length()-16; i+=16)
-        {
-            QByteArray lineData = data.data.mid(i,16);
-            uint16_t lineAddress = (uint16_t)data.offset+i;
-            QByteArray line;
-            line.append((uint8_t)16); // Lenght
-            line.append((uint8_t)(lineAddress>>8));
-            line.append((uint8_t)lineAddress);
-            line.append((uint8_t)RecordType::Data);
-            line.append(lineData);
-            line.append((uint8_t)_calculateChecksum(line));
-
-            QString lineSting = ":"+line.toHex();
-            out << lineSting.toUpper() << Qt::endl;
-        }
-
-        uint16_t lineAddress = (uint16_t)data.offset+i;
-        QByteArray line;
-        line.append((uint8_t)(data.data.length()-i)); // Lenght
-        line.append((uint8_t)(lineAddress>>8));
-        line.append((uint8_t)lineAddress);
-        line.append((uint8_t)RecordType::Data);
-        line.append(data.data.mid(i));
-        line.append((uint8_t)_calculateChecksum(line));
-
-        QString lineSting = ":"+line.toHex();
-        out << lineSting.toUpper() << Qt::endl;
-    }
-    out << ":00000001FF" << Qt::endl; // Add end of file
-
-    out.flush();
-    hexFile.close();
-
+    }
     return true;
 }
 
-void HexFileParser::_parseLine(uint32_t lineIndex, QString line)
+void HexFileParser::replace(uint32_t address, QByteArray data)
 {
-    if(line.at(0) != ':')
+    if(data.isEmpty()) return; // an empty write creates no range, but would add a CRC cache entry
+
+    Range chunk;
+    if(_image.rangeAt(address, chunk) && _image.contains(address, data.length()))
     {
-        _error.append(FileError{lineIndex,ErrorType::InvalidStartCode});
+        if(_crcCacheEnabled)
+        {
+            // CRC is linear: crc(old ^ delta) = crc(old) ^ crc of delta with zero initial value
+            QByteArray delta = _image.read(address, data.length(), 0x00);
+            for(qsizetype j = 0; j < delta.size(); j++)
+            {
+                delta[j] = delta.at(j) ^ data.at(j);
+            }
+            uint32_t deltaCrc = Crc::crc32_addData(0, delta);
+            deltaCrc = Crc::crc32_addFill(deltaCrc, 0x00, (uint64_t)chunk.maximum - address - data.length() + 1);
+            _chunkCrc[chunk.minimum] ^= deltaCrc;
+        }
+        _image.overwrite(address, data);
         return;
     }
 
-    bool ok;
-    uint8_t lineByteCount = line.mid(1,2).toUInt(&ok,16);
-    if(!ok || lineByteCount*2+11 != line.length()){
-        _error.append(FileError{lineIndex,ErrorType::InvalidLineLength});
-        return;
-    }
+    // The data reaches outside of a chunk, the merged chunk gets a new CRC
+    _updateChunkCrc(_image.write(address, data));
+    _updateBinaryAddressRange();
+}
 
-    RecordType lineRecordType = (RecordType)line.mid(7 ,2).toUInt(&ok,16);
-    if(!ok){
-        _error.append(FileError{lineIndex,ErrorType::InvalidRecordType});
-        return;
-    }
+void HexFileParser::insert(const BinaryChunk &data)
+{
+    // TODO: Check inside address range
+    if(data.data.isEmpty()) return;
+    _updateChunkCrc(_image.write(data.offset, data.data));
+    _updateBinaryAddressRange();
+}
 
-    uint8_t lineAddressHighByte = line.mid(3,2).toUInt(&ok,16);
-    if(!ok){
-        _error.append(FileError{lineIndex,ErrorType::InvalidAddressByte});
-        return;
-    }
+uint32_t HexFileParser::crc32(uint32_t address, uint32_t size) const
+{
+    return _crc(FlashHash::Crc32, address, size, _fillValue);
+}
 
-    uint8_t lineAddressLowByte = line.mid(5,2).toUInt(&ok,16);
-    if(!ok){
-        _error.append(FileError{lineIndex,ErrorType::InvalidAddressByte});
-        return;
-    }
-    uint16_t lineAddress = ((uint16_t)lineAddressHighByte<<8) | lineAddressLowByte;
+uint32_t HexFileParser::crc32Stm32(uint32_t address, uint32_t size) const
+{
+    return _crc(FlashHash::Crc32Stm32, address, size, _fillValue);
+}
 
-    QByteArray lineData;
-    uint8_t checksum = lineByteCount + (uint8_t)lineRecordType + lineAddressHighByte+lineAddressLowByte;
-    for(uint32_t i = 0; i < lineByteCount; i++)
+uint32_t HexFileParser::_crc(FlashHash hash, uint32_t address, uint32_t size, uint8_t fillValue) const
+{
+    if(hash == FlashHash::Crc32c)
     {
-        uint8_t byte = line.mid(i*2+9 ,2).toUInt(&ok,16);
-        if(!ok){
-            _error.append(FileError{lineIndex,ErrorType::InvalidDataByte});
-            return;
-        }
-        lineData.append(byte);
-
-        checksum+= byte;
-    }
-    checksum += line.mid(line.length()-2 ,2).toUInt(&ok,16);
-    if(!ok || checksum != 0){
-        _error.append(FileError{lineIndex,ErrorType::InvalidChecksum});
-        return;
+        uint32_t crc = Crc::crc32c_initValue;
+        _image.walk(address, size,
+            [&](QByteArrayView data){ crc = Crc::crc32c_addData(crc, data); },
+            [&](uint64_t count){ crc = Crc::crc32c_addFill(crc, fillValue, count); });
+        return crc;
     }
 
-    switch (lineRecordType) {
-        case RecordType::Data:{
-            uint32_t lineStartAddress = _high16BitAddress+lineAddress;
-            uint32_t lineEndAddress = _high16BitAddress+lineAddress + lineByteCount-1;
-
-            if(_fileAddress.minimum > lineStartAddress) _fileAddress.minimum = lineStartAddress;
-            if(_fileAddress.maximum < lineEndAddress) _fileAddress.maximum = lineEndAddress;
+    if(hash == FlashHash::Crc32)
+    {
+        uint32_t crc = Crc::crc32_initValue;
+        _image.walk(address, size,
+            [&](QByteArrayView data){ crc = Crc::crc32_addData(crc, data); },
+            [&](uint64_t count){ crc = Crc::crc32_addFill(crc, fillValue, count); });
+        return crc;
+    }
 
-            if(_memorySize.minimum > lineStartAddress) {
-                _warning.append(FileError{lineIndex,ErrorType::AddressRangeTooLow});
-                return;
+    // Words that span a chunk border or a gap are assembled here, everything else is read from the chunks directly
+    uint32_t crc = Crc::crc32Stm32_initValue;
+    uint8_t word[4];
+    uint8_t wordLength = 0;
+
+    _image.walk(address, size,
+        [&](QByteArrayView data){
+            while(wordLength && !data.isEmpty()){
+                word[wordLength++] = data.front();
+                data = data.sliced(1);
+                if(wordLength == 4){
+                    crc = Crc::crc32Stm32_addData(crc, QByteArrayView(word, 4));
+                    wordLength = 0;
+                }
             }
-
-            if(_memorySize.maximum < lineEndAddress) {
-                _warning.append(FileError{lineIndex,ErrorType::AddressRangeTooHigh});
-                return;
+            qsizetype alignedSize = data.size() & ~(qsizetype)3;
+            crc = Crc::crc32Stm32_addData(crc, data.first(alignedSize));
+            for(char byte: data.sliced(alignedSize)) word[wordLength++] = byte;
+        },
+        [&](uint64_t count){
+            while(wordLength && count){
+                word[wordLength++] = fillValue;
+                count--;
+                if(wordLength == 4){
+                    crc = Crc::crc32Stm32_addData(crc, QByteArrayView(word, 4));
+                    wordLength = 0;
+                }
             }
+            crc = Crc::crc32Stm32_addFill(crc, fillValue, count & ~(uint64_t)3);
+            for(count &= 3; count; count--) word[wordLength++] = fillValue;
+        });
 
-            _binary.append(BinaryChunk{_high16BitAddress+lineAddress, lineData});
-            break;
-        }
+    return Crc::crc32Stm32_addData(crc, QByteArrayView(word, wordLength));
+}
 
-        case RecordType::EndOfFile:
-            return;
+#define MIN_BYTES_PER_THREAD (1024*1024) // for automatic thread count
 
-        case RecordType::ExtendedLinearAddress:
-            _high16BitAddress = (line.mid(9,4).toUInt(&ok,16))<<16;
-            if(!ok){
-                _error.append(FileError{lineIndex,ErrorType::InvalidAddressByte});
-                return;
-            }
-            break;
+QList<uint32_t> HexFileParser::hashManifest(const FlashGeometry &geometry, FlashHash hash, bool perPage) const
+{
+    QList<Range> blocks;
+    uint64_t totalSize = 0;
+    for(const Range &sector: geometry.sectors)
+    {
+        uint64_t blockSize = perPage && geometry.pageSize ? geometry.pageSize : (uint64_t)sector.maximum - sector.minimum + 1;
+        for(uint64_t address = sector.minimum; address <= sector.maximum; address += blockSize)
+        {
+            blocks.append(Range{(uint32_t)address, (uint32_t)std::min<uint64_t>(address + blockSize - 1, sector.maximum)});
+        }
+        totalSize += (uint64_t)sector.maximum - sector.minimum + 1;
+    }
 
-        case RecordType::ExtendedSegmentAddress:
-            _high16BitAddress = (line.mid(9,4).toUInt(&ok,16))<<4;
-            if(!ok){
-                _error.append(FileError{lineIndex,ErrorType::InvalidAddressByte});
-                return;
-            }
-            break;
+    uint32_t threadCount = _threadCount;
+    if(threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+        threadCount = std::min<uint64_t>(threadCount, totalSize/MIN_BYTES_PER_THREAD + 1);
+    }
+    threadCount = std::max<qsizetype>(1, std::min<qsizetype>(threadCount, blocks.size()));
 
-        case RecordType::StartLinearAddress:
-        case RecordType::StartSegmentAddress:
-            break;
+    // Every thread hashes a consecutive run of blocks, gaps are hashed as fill without reading memory
+    QList<uint32_t> manifest(blocks.size());
+    uint32_t *output = manifest.data();
+    auto hashBlocks = [&](qsizetype first, qsizetype last){
+        for(qsizetype i = first; i < last; i++)
+        {
+            output[i] = _crc(hash, blocks.at(i).minimum, blocks.at(i).maximum - blocks.at(i).minimum + 1, geometry.erasedValue);
+        }
+    };
+    if(threadCount == 1)
+    {
+        hashBlocks(0, blocks.size());
+        return manifest;
+    }
 
-        default:
-            _error.append(FileError{lineIndex,ErrorType::InvalidRecordType});
-            break;
+    std::vector<std::thread> threads;
+    for(uint32_t i = 0; i < threadCount; i++)
+    {
+        threads.emplace_back(hashBlocks, blocks.size()*i/threadCount, blocks.size()*(i+1)/threadCount);
     }
+    for(std::thread &thread: threads) thread.join();
+    return manifest;
 }
 
-void HexFileParser::_combineBinaryChunks()
+QList<qsizetype> HexFileParser::compareManifest(const QList<uint32_t> &manifest, const QList<uint32_t> &deviceManifest)
 {
-    if(_binary.empty()){
-        _binaryAddress.minimum = 0;
-        _binaryAddress.maximum = 0;
-
-        return;
+    QList<qsizetype> changed;
+    for(qsizetype i = 0; i < manifest.size(); i++)
+    {
+        if(i >= deviceManifest.size() || manifest.at(i) != deviceManifest.at(i)) changed.append(i);
     }
+    return changed;
+}
 
-    std::sort(_binary.begin(), _binary.end(), [](const BinaryChunk &a, const BinaryChunk &b){ return a.offset < b.offset; } );
-
-    QList<BinaryChunk> combinedBinary;
+void HexFileParser::setCrcCacheEnabled(bool enabled)
+{
+    _crcCacheEnabled = enabled;
+    _updateCrcCache();
+}
 
-    QByteArray nextData;
-    uint32_t chunkOffse = 0xFFFFFFFF;
-    uint32_t nextOffset = _binary.first().offset;
+uint32_t HexFileParser::imageCrc32() const
+{
+    if(_image.isEmpty()) return Crc::crc32_initValue;
 
-    for(const BinaryChunk &data: std::as_const(_binary))
+    if(!_crcCacheEnabled)
     {
-        if(nextOffset != data.offset) // If data in the address space is missing
-        {
-            if(data.offset <= nextOffset + _addressGapSize) // if gap is smaller as specefied gap size -> fill in data
-            {
-               uint32_t gapFillSize = data.offset - nextOffset;
-               for(uint32_t i = 0; i< gapFillSize; i++)
-               {
-                   nextData.append(_fillValue);
-               }
-               nextOffset += gapFillSize + data.data.length();
-            }
-            else // Start a new chunk
-            {
-                if(nextData.length()){
-                    combinedBinary.append(_fixChunkAddressAlignment(chunkOffse, nextData));
-                }
-                nextData.clear();
-                chunkOffse = 0xFFFFFFFF;
-            }
-        }
-        else
-        {
-            nextOffset = data.offset + data.data.length();
-        }
+        return crc32(_image.firstAddress(), _image.lastAddress() - _image.firstAddress() + 1);
+    }
 
-        if(chunkOffse == 0xFFFFFFFF)
+    // The cache has one entry per chunk, both are ordered by offset
+    uint32_t crc = Crc::crc32_initValue;
+    uint64_t nextOffset = _image.firstAddress();
+    QMap<uint32_t, uint32_t>::const_iterator chunkCrc = _chunkCrc.cbegin();
+    for(const Range &chunk: _image.ranges())
+    {
+        if(chunk.minimum > nextOffset)
         {
-            nextOffset = data.offset + data.data.length();
-            chunkOffse = data.offset;
+            crc = Crc::crc32_addFill(crc, _fillValue, chunk.minimum - nextOffset);
         }
-        nextData.append(data.data);
+        crc = Crc::crc32_combine(crc, chunkCrc.value(), (uint64_t)chunk.maximum - chunk.minimum + 1);
+        nextOffset = (uint64_t)chunk.maximum + 1;
+        ++chunkCrc;
     }
-    combinedBinary.append(_fixChunkAddressAlignment(chunkOffse, nextData));
-    _binary = combinedBinary;
-
-    _binaryAddress.minimum =_binary.first().offset;
-    _binaryAddress.maximum =_binary.last().offset+_binary.last().data.length()-1;
+    return crc;
 }
 
-HexFileParser::BinaryChunk HexFileParser::_fixChunkAddressAlignment(uint32_t offset, QByteArray data)
+void HexFileParser::_updateCrcCache()
 {
-    // Fill beginning of data chunk
-    uint32_t alignedOffset = offset;
-    if(offset % _addressAlignment != 0)
+    _chunkCrc.clear();
+    if(!_crcCacheEnabled) return;
+
+    for(const Range &chunk: _image.ranges())
     {
-        uint32_t fillCount = offset - (offset - (offset % _addressAlignment));
-        alignedOffset -= fillCount;
-        for(uint32_t i = 0; i< fillCount; i++)
-        {
-            data.prepend(_fillValue);
-        }
+        _chunkCrc.insert(chunk.minimum, crc32(chunk.minimum, chunk.maximum - chunk.minimum + 1));
     }
+}
+
+void HexFileParser::_updateChunkCrc(const Range &chunk)
+{
+    if(!_crcCacheEnabled) return;
 
-     // Fill end of data chunk
-    uint32_t chunkEndAddress = offset+data.length();
-    if(chunkEndAddress % _addressAlignment != 0)
+    // Drop the entries of the chunks that were merged into this one
+    QMap<uint32_t, uint32_t>::iterator entry = _chunkCrc.lowerBound(chunk.minimum);
+    while(entry != _chunkCrc.end() && entry.key() <= chunk.maximum)
     {
-        uint32_t fillCount = _addressAlignment - (data.length() % _addressAlignment);
-        for(uint32_t i = 0; i< fillCount; i++)
-        {
-            data.append(_fillValue);
-        }
+        entry = _chunkCrc.erase(entry);
+    }
+    _chunkCrc.insert(chunk.minimum, crc32(chunk.minimum, chunk.maximum - chunk.minimum + 1));
+}
+
+void HexFileParser::_updateBinaryAddressRange()
+{
+    if(_image.isEmpty()){
+        _binaryAddress.minimum = 0;
+        _binaryAddress.maximum = 0;
+        return;
+    }
+    _binaryAddress.minimum = _image.firstAddress();
+    _binaryAddress.maximum = _image.lastAddress();
+}
+
+const HexFileParser::Range &HexFileParser::fileAddressRange() const
+{
+    return _fileAddress;
+}
+
+const HexFileParser::Range &HexFileParser::binaryAddressRange() const
+{
+    return _binaryAddress;
+}
+
+const HexFileParser::Range &HexFileParser::memoryAddressRange() const
+{
+    return _memorySize;
+}
+
+bool HexFileParser::load(QString filePath)
+{
+    return _loadFile(filePath, {_builtInReaders().at(IntelHexReader)});
+}
+
+bool HexFileParser::load(QByteArrayView data)
+{
+    return _loadData(data, {_builtInReaders().at(IntelHexReader)});
+}
+
+#define STREAM_BLOCK_SIZE (1024*1024) // bytes read from a device at once
+
+// An end of file record that isn't followed by a line end yet, the record has a fixed length
+static bool isIntelHexEndOfFile(QByteArrayView line)
+{
+    while(!line.isEmpty() && isspace((uint8_t)line.back())) line = line.chopped(1);
+    while(!line.isEmpty() && isspace((uint8_t)line.front())) line = line.sliced(1);
+    return line.size() == 11 && line.startsWith(":00000001");
+}
+
+bool HexFileParser::load(QIODevice &device)
+{
+    _startLoad();
+    if(!device.isReadable()){
+        _error.append(FileError{0,ErrorType::FileNotOpen});
+        return false;
+    }
+    _fileFormat = _builtInReaders().at(IntelHexReader).name;
+    if(_loadState && !device.isSequential()) _loadState->bytesTotal = device.size() - device.pos();
+
+    // Complete lines are parsed as they arrive, a partial line at the end of a block is moved to the start of the buffer
+    ParseContext context;
+    QByteArray buffer(STREAM_BLOCK_SIZE, Qt::Uninitialized);
+    qsizetype carry = 0;
+    while(true)
+    {
+        if(carry == buffer.size()) buffer.resize(buffer.size()*2); // line longer than the buffer
+
+        qint64 count = device.read(buffer.data() + carry, buffer.size() - carry);
+        if(count == 0 && isIntelHexEndOfFile(QByteArrayView(buffer.constData(), carry))) break;
+        if(count == 0 && device.isSequential() && device.waitForReadyRead(_streamTimeout)) continue;
+        if(count <= 0) break;
+
+        const char *text = buffer.constData();
+        qsizetype size = carry + count;
+        qsizetype linesEnd = size;
+        while(linesEnd > 0 && text[linesEnd-1] != '\n') linesEnd--;
+        _parseRange(QByteArrayView(text, linesEnd), context, &HexFileParser::_parseIntelHexLine);
+
+        carry = size - linesEnd;
+        memmove(buffer.data(), text + linesEnd, carry);
+        if(context.endOfFile){ // a device that stays open isn't waited for, the rest of the stream is not read
+            carry = 0;
+            break;
+        }
+        if(_loadState && _loadState->canceled) break;
+    }
+    _parseRange(QByteArrayView(buffer.constData(), carry), context, &HexFileParser::_parseIntelHexLine);
+
+    ReaderOutput output;
+    _mergeContexts({context}, output);
+    return _finishLoad(output);
+}
+
+bool HexFileParser::loadSRecord(QString filePath)
+{
+    return _loadFile(filePath, {_builtInReaders().at(SRecordReader)});
+}
+
+bool HexFileParser::loadElf(QString filePath)
+{
+    return _loadFile(filePath, {_builtInReaders().at(ElfReader)});
+}
+
+bool HexFileParser::loadTiTxt(QString filePath)
+{
+    return _loadFile(filePath, {_builtInReaders().at(TiTxtReader)});
+}
+
+bool HexFileParser::loadBinary(QString filePath)
+{
+    return _loadFile(filePath, {_builtInReaders().at(BinaryReader)});
+}
+
+bool HexFileParser::loadAutoDetect(QString filePath)
+{
+    return _loadFile(filePath, readers());
+}
+
+const QString &HexFileParser::fileFormat() const
+{
+    return _fileFormat;
+}
+
+static QList<HexFileParser::FileReader> &registeredReaders()
+{
+    static QList<HexFileParser::FileReader> readers;
+    return readers;
+}
+
+void HexFileParser::registerReader(const FileReader &reader)
+{
+    registeredReaders().append(reader);
+}
+
+bool HexFileParser::unregisterReader(const QString &name)
+{
+    QList<FileReader> &readers = registeredReaders();
+    qsizetype count = readers.count();
+    for(qsizetype i = count-1; i >= 0; i--)
+    {
+        if(readers.at(i).name == name) readers.removeAt(i);
+    }
+    return readers.count() != count;
+}
+
+QList<HexFileParser::FileReader> HexFileParser::readers()
+{
+    QList<FileReader> output = registeredReaders();
+    output.append(_builtInReaders());
+    return output;
+}
+
+// The text from the first character that is not white space
+static QByteArrayView skipWhitespace(QByteArrayView text)
+{
+    while(!text.isEmpty() && isspace((uint8_t)text.front())) text = text.sliced(1);
+    return text;
+}
+
+const QList<HexFileParser::FileReader> &HexFileParser::_builtInReaders()
+{
+    // Same order as BuiltInReader, binary accepts any file and comes last
+    static const QList<FileReader> readers = {
+        FileReader{"ELF",
+            [](QByteArrayView head){ return head.startsWith("\x7F" "ELF"); },
+            [](const HexFileParser &parser, QByteArrayView data, ReaderOutput &output){ parser._parseElf(data, output); }},
+        FileReader{"Intel HEX",
+            [](QByteArrayView head){ head = skipWhitespace(head); return !head.isEmpty() && head.front() == ':'; },
+            [](const HexFileParser &parser, QByteArrayView data, ReaderOutput &output){ parser._parse(data, &HexFileParser::_parseIntelHexLine, output); }},
+        FileReader{"S-record",
+            [](QByteArrayView head){ head = skipWhitespace(head); return head.size() >= 2 && head.at(0) == 'S' && isdigit((uint8_t)head.at(1)); },
+            [](const HexFileParser &parser, QByteArrayView data, ReaderOutput &output){ parser._parse(data, &HexFileParser::_parseSRecordLine, output); }},
+        FileReader{"TI-TXT",
+            [](QByteArrayView head){ head = skipWhitespace(head); return !head.isEmpty() && head.front() == '@'; },
+            [](const HexFileParser &parser, QByteArrayView data, ReaderOutput &output){ parser._parse(data, &HexFileParser::_parseTiTxtLine, output); }},
+        FileReader{"Binary",
+            [](QByteArrayView){ return true; },
+            [](const HexFileParser &parser, QByteArrayView data, ReaderOutput &output){ parser._parseBinary(data, output); }}
+    };
+    return readers;
+}
+
+#define PROBE_SIZE 512 // bytes of the file passed to the probe functions
+
+bool HexFileParser::_loadFile(QString filePath, const QList<FileReader> &readers)
+{
+    if(_loadCacheEnabled && _loadCache(filePath, readers)){
+        if(_loadState) _loadState->bytesTotal = _loadState->bytesProcessed = QFileInfo(filePath).size();
+        return true;
+    }
+
+    QFile hexFile(filePath);
+    if(!hexFile.open(QIODevice::ReadOnly)){
+        _startLoad();
+        _error.append(FileError{0,ErrorType::FileNotOpen});
+        return false;
+    }
+    if(_loadState) _loadState->bytesTotal = hexFile.size();
+
+    // Parse the raw bytes of the mapped file, fall back to reading it if it can't be mapped
+    QByteArray content;
+    QByteArrayView data;
+    uchar *map = nullptr;
+    if(hexFile.size() > 0) map = hexFile.map(0, hexFile.size());
+    if(map){
+        data = QByteArrayView(map, hexFile.size());
+    }else{
+        content = hexFile.readAll();
+        data = content;
+    }
+
+    bool ok = _loadData(data, readers);
+    if(ok && _loadCacheEnabled) _saveCache(filePath, data);
+
+    if(map) hexFile.unmap(map);
+    hexFile.close();
+    return ok;
+}
+
+bool HexFileParser::_loadData(QByteArrayView data, const QList<FileReader> &readers)
+{
+    _startLoad();
+
+    const FileReader *reader = &readers.first();
+    if(readers.size() > 1){
+        QByteArrayView head = data.first(std::min<qsizetype>(data.size(), PROBE_SIZE));
+        for(const FileReader &candidate: readers){
+            if(candidate.probe(head)){
+                reader = &candidate;
+                break;
+            }
+        }
+    }
+    _fileFormat = reader->name;
+
+    // The chunks may point into the data, they are copied into the image before it is released
+    ReaderOutput output;
+    reader->parse(*this, data, output);
+    return _finishLoad(output);
+}
+
+void HexFileParser::_startLoad()
+{
+    _error.clear();
+    _warning.clear();
+    _image.clear();
+    _chunkCrc.clear();
+    _fileFormat.clear();
+}
+
+bool HexFileParser::_finishLoad(const ReaderOutput &output)
+{
+    if(_loadState){
+        if(_loadState->canceled){
+            _error.append(FileError{0,ErrorType::Canceled});
+            return false;
+        }
+        _loadState->bytesProcessed = _loadState->bytesTotal.load();
+    }
+
+    _error.append(output.error);
+    _warning.append(output.warning);
+    _fileAddress = output.fileAddress;
+    if(_error.count() == 0) _combineBinaryChunks(output.binary);
+
+    return _error.count() == 0;
+}
+
+void HexFileParser::setLoadCacheEnabled(bool enabled)
+{
+    _loadCacheEnabled = enabled;
+}
+
+QString HexFileParser::cacheFilePath(const QString &filePath)
+{
+    return filePath + ".qucache";
+}
+
+#define CACHE_MAGIC "QUCHEX"
+#define CACHE_VERSION 1
+#define CACHE_MODIFIED_OFFSET 18 // after the magic, version, reserved field and source size
+
+namespace {
+
+// The cache file is little endian: header, format name, warnings, chunk index and chunk data, each section starts 8 byte aligned.
+// The header holds the source file size, modification time and CRC-32C and the parser settings the image depends on.
+class CacheWriter
+{
+public:
+    void add16(uint16_t value) { _add(value); }
+    void add32(uint32_t value) { _add(value); }
+    void add64(uint64_t value) { _add(value); }
+    void addData(QByteArrayView data) { _data.append(data.data(), data.size()); }
+    void align(void) { _data.append((8 - _data.size() % 8) % 8, '\0'); }
+
+    qsizetype size(void) const { return _data.size(); }
+    const QByteArray &data(void) const { return _data; }
+
+private:
+    template<typename T> void _add(T value)
+    {
+        char bytes[sizeof(T)];
+        qToLittleEndian<T>(value, bytes);
+        _data.append(bytes, sizeof(T));
+    }
+
+    QByteArray _data;
+};
+
+// Reads the sections in order, ok() turns false on the first read past the end
+class CacheReader
+{
+public:
+    explicit CacheReader(QByteArrayView data): _data(data) {}
+
+    template<typename T> T read(void)
+    {
+        if(!_ok || _position + (qsizetype)sizeof(T) > _data.size()){
+            _ok = false;
+            return 0;
+        }
+        T value = qFromLittleEndian<T>(_data.data() + _position);
+        _position += sizeof(T);
+        return value;
+    }
+    QByteArrayView read(uint64_t length)
+    {
+        if(!_ok || length > (uint64_t)(_data.size() - _position)){
+            _ok = false;
+            return QByteArrayView();
+        }
+        QByteArrayView data = _data.sliced(_position, length);
+        _position += length;
+        return data;
+    }
+    QByteArrayView at(uint64_t position, uint64_t length)
+    {
+        if(position > (uint64_t)_data.size() || length > _data.size() - position){
+            _ok = false;
+            return QByteArrayView();
+        }
+        return _data.sliced(position, length);
+    }
+    void align(void) { _position = std::min<qsizetype>(_data.size(), (_position + 7) & ~(qsizetype)7); }
+
+    bool ok(void) const { return _ok; }
+
+private:
+    QByteArrayView _data;
+    qsizetype _position = 0;
+    bool _ok = true;
+};
+
+}
+
+bool HexFileParser::_loadCache(const QString &filePath, const QList<FileReader> &readers)
+{
+    QFileInfo source(filePath);
+    QFile cacheFile(cacheFilePath(filePath));
+    if(!source.exists() || !cacheFile.open(QIODevice::ReadOnly)) return false;
+
+    uchar *map = cacheFile.size() > 0 ? cacheFile.map(0, cacheFile.size()) : nullptr;
+    if(map == nullptr) return false;
+    CacheReader cache(QByteArrayView(map, cacheFile.size()));
+
+    bool valid = cache.read(6) == QByteArrayView(CACHE_MAGIC) && cache.read<uint16_t>() == CACHE_VERSION;
+    cache.read<uint16_t>();
+    uint64_t sourceSize = cache.read<uint64_t>();
+    int64_t sourceModified = cache.read<int64_t>();
+    uint32_t sourceHash = cache.read<uint32_t>();
+    valid &= cache.read<uint32_t>() == _memorySize.minimum;
+    valid &= cache.read<uint32_t>() == _memorySize.maximum;
+    valid &= cache.read<uint32_t>() == _addressGapSize;
+    valid &= cache.read<uint32_t>() == _addressAlignment;
+    valid &= cache.read<uint32_t>() == _fillValue;
+    Range fileAddress;
+    fileAddress.minimum = cache.read<uint32_t>();
+    fileAddress.maximum = cache.read<uint32_t>();
+    uint32_t formatLength = cache.read<uint32_t>();
+    uint32_t warningCount = cache.read<uint32_t>();
+    uint32_t chunkCount = cache.read<uint32_t>();
+    cache.align();
+
+    // The file format has to be one the caller asked for
+    QString format = QString::fromUtf8(cache.read(formatLength));
+    valid &= readers.size() > 1 ? std::any_of(readers.begin(), readers.end(), [&](const FileReader &reader){ return reader.name == format; })
+                                : readers.first().name == format;
+
+    // Size and modification time tell an unchanged file, a file with a new time but the same size is compared by its hash
+    valid &= cache.ok() && sourceSize == (uint64_t)source.size();
+    int64_t modified = source.lastModified().toMSecsSinceEpoch();
+    bool hashed = valid && sourceModified != modified;
+    if(hashed){
+        bool ok = false;
+        valid = Crc::crc32cFile(filePath, &ok) == sourceHash && ok;
+    }
+
+    QList<FileError> warnings;
+    QList<Range> ranges;
+    QList<QByteArrayView> data;
+    if(valid){
+        cache.align();
+        for(uint32_t i = 0; i < warningCount && cache.ok(); i++){
+            FileError warning;
+            warning.lineIndex = cache.read<uint32_t>();
+            warning.error = (ErrorType)cache.read<uint32_t>();
+            warning.column = cache.read<uint32_t>();
+            warnings.append(warning);
+        }
+        cache.align();
+        for(uint32_t i = 0; i < chunkCount && cache.ok(); i++){
+            Range range;
+            range.minimum = cache.read<uint32_t>();
+            range.maximum = cache.read<uint32_t>();
+            uint64_t dataOffset = cache.read<uint64_t>();
+            ranges.append(range);
+            data.append(cache.at(dataOffset, (uint64_t)range.maximum - range.minimum + 1));
+        }
+        valid = cache.ok();
+    }
+
+    if(valid){
+        _startLoad();
+        _fileFormat = format;
+        _warning.append(warnings);
+        _fileAddress = fileAddress;
+        for(qsizetype i = 0; i < ranges.size(); i++){
+            _image.write(ranges.at(i).minimum, data.at(i));
+        }
+        _updateBinaryAddressRange();
+        _updateCrcCache();
+    }
+
+    cacheFile.unmap(map);
+    cacheFile.close();
+
+    // The file was touched but is unchanged, its new time lets later loads skip the hash
+    if(valid && hashed && cacheFile.open(QIODevice::ReadWrite) && cacheFile.seek(CACHE_MODIFIED_OFFSET)){
+        uchar time[8];
+        qToLittleEndian<int64_t>(modified, time);
+        cacheFile.write(reinterpret_cast<const char*>(time), sizeof(time));
+        cacheFile.close();
+    }
+    return valid;
+}
+
+void HexFileParser::_saveCache(const QString &filePath, QByteArrayView source) const
+{
+    QList<Range> ranges = _image.ranges();
+
+    CacheWriter cache;
+    cache.addData(CACHE_MAGIC);
+    cache.add16(CACHE_VERSION);
+    cache.add16(0);
+    cache.add64(source.size());
+    cache.add64(QFileInfo(filePath).lastModified().toMSecsSinceEpoch());
+    cache.add32(Crc::crc32c(source));
+    cache.add32(_memorySize.minimum);
+    cache.add32(_memorySize.maximum);
+    cache.add32(_addressGapSize);
+    cache.add32(_addressAlignment);
+    cache.add32(_fillValue);
+    cache.add32(_fileAddress.minimum);
+    cache.add32(_fileAddress.maximum);
+    QByteArray format = _fileFormat.toUtf8();
+    cache.add32(format.size());
+    cache.add32(_warning.size());
+    cache.add32(ranges.size());
+    cache.align();
+
+    cache.addData(format);
+    cache.align();
+    for(const FileError &warning: _warning){
+        cache.add32(warning.lineIndex);
+        cache.add32((uint32_t)warning.error);
+        cache.add32(warning.column);
+    }
+    cache.align();
+
+    // Chunk data follows the index, each chunk 8 byte aligned
+    uint64_t dataOffset = cache.size() + (uint64_t)ranges.size() * 16;
+    for(const Range &range: std::as_const(ranges)){
+        cache.add32(range.minimum);
+        cache.add32(range.maximum);
+        cache.add64(dataOffset);
+        dataOffset = (dataOffset + (uint64_t)range.maximum - range.minimum + 1 + 7) & ~(uint64_t)7;
+    }
+
+    // Written to a temporary file that replaces the cache on commit, a load never maps a partly written cache
+    QSaveFile cacheFile(cacheFilePath(filePath));
+    if(!cacheFile.open(QIODevice::WriteOnly)) return;
+
+    bool ok = cacheFile.write(cache.data()) == cache.size();
+    for(const Range &range: std::as_const(ranges)){
+        _image.walk(range.minimum, range.maximum - range.minimum + 1,
+            [&](QByteArrayView data){ ok &= cacheFile.write(data.data(), data.size()) == data.size(); },
+            [](uint64_t){});
+        uint64_t padding = (8 - ((uint64_t)range.maximum - range.minimum + 1) % 8) % 8;
+        ok &= cacheFile.write("\0\0\0\0\0\0\0", padding) == (qint64)padding;
+    }
+
+    if(ok) cacheFile.commit(); // discarded otherwise
+}
+
+HexFileParser::LoadTask HexFileParser::loadAsync(QString filePath, bool (HexFileParser::*load)(QString)) const
+{
+    LoadTask task;
+    task._state = std::make_shared<LoadState>();
+
+    HexFileParser parser = *this;
+    std::shared_ptr<LoadState> state = task._state;
+    task._result = std::async(std::launch::async, [parser, filePath, load, state]() mutable {
+        parser._loadState = state.get();
+        (parser.*load)(filePath);
+        parser._loadState = nullptr;
+        return parser;
+    }).share();
+    return task;
+}
+
+void HexFileParser::LoadTask::cancel()
+{
+    _state->canceled = true;
+}
+
+bool HexFileParser::LoadTask::isFinished() const
+{
+    return _result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+qint64 HexFileParser::LoadTask::bytesProcessed() const
+{
+    return _state->bytesProcessed;
+}
+
+qint64 HexFileParser::LoadTask::bytesTotal() const
+{
+    return _state->bytesTotal;
+}
+
+const HexFileParser &HexFileParser::LoadTask::result() const
+{
+    return _result.get();
+}
+
+std::shared_future<HexFileParser> HexFileParser::LoadTask::future() const
+{
+    return _result;
+}
+
+bool HexFileParser::saveToFile(QString filePath)
+{
+    QFile hexFile(filePath);
+    if(!hexFile.open(QIODevice::WriteOnly)){
+        return false;
+    }
+
+    RecordWriter writer(hexFile);
+    uint32_t high16BitAddress = 0;
+    _forEachRecord(_recordLength, 0x10000, [&](uint32_t address, const uint8_t *data, uint8_t length){
+        if((address & 0xFFFF0000) != high16BitAddress)
+        {
+            high16BitAddress = address & 0xFFFF0000;
+            uint8_t extendedAddress[2] = {(uint8_t)(high16BitAddress>>24), (uint8_t)(high16BitAddress>>16)};
+            writer.commit(encodeRecord(writer.reserve(), (uint8_t)RecordType::ExtendedLinearAddress, 0, extendedAddress, 2));
+        }
+        writer.commit(encodeRecord(writer.reserve(), (uint8_t)RecordType::Data, (uint16_t)address, data, length));
+    });
+    writer.commit(encodeRecord(writer.reserve(), (uint8_t)RecordType::EndOfFile, 0, nullptr, 0));
+
+    bool ok = writer.flush();
+    hexFile.close();
+    return ok;
+}
+
+bool HexFileParser::saveToSRecordFile(QString filePath)
+{
+    QFile srecFile(filePath);
+    if(!srecFile.open(QIODevice::WriteOnly)){
+        return false;
+    }
+
+    // The smallest address size that covers the image: S1/S9, S2/S8 or S3/S7
+    uint32_t lastAddress = _image.isEmpty() ? 0 : _image.lastAddress();
+    uint8_t addressLength = lastAddress <= 0xFFFF ? 2 : lastAddress <= 0xFFFFFF ? 3 : 4;
+    char dataType = '1' + addressLength - 2;
+    char terminationType = '9' - addressLength + 2;
+
+    RecordWriter writer(srecFile);
+    uint32_t recordCount = 0;
+    writer.commit(encodeSRecord(writer.reserve(), '0', 0, 2, nullptr, 0));
+    _forEachRecord(std::min<uint8_t>(_recordLength, 255 - addressLength - 1), 0, [&](uint32_t address, const uint8_t *data, uint8_t length){
+        writer.commit(encodeSRecord(writer.reserve(), dataType, address, addressLength, data, length));
+        recordCount++;
+    });
+    if(recordCount <= 0xFFFF) writer.commit(encodeSRecord(writer.reserve(), '5', recordCount, 2, nullptr, 0));
+    else if(recordCount <= 0xFFFFFF) writer.commit(encodeSRecord(writer.reserve(), '6', recordCount, 3, nullptr, 0));
+    writer.commit(encodeSRecord(writer.reserve(), terminationType, 0, addressLength, nullptr, 0));
+
+    bool ok = writer.flush();
+    srecFile.close();
+    return ok;
+}
+
+void HexFileParser::_forEachRecord(uint8_t recordLength, uint32_t border, const std::function<void (uint32_t, const uint8_t *, uint8_t)> &record) const
+{
+    uint8_t recordData[255];
+    for(const Range &range: _image.ranges())
+    {
+        uint32_t recordAddress = range.minimum;
+        uint32_t length = 0;
+        _image.walk(range.minimum, range.maximum - range.minimum + 1,
+            [&](QByteArrayView data){
+                while(!data.isEmpty())
+                {
+                    // A record ends at the record length or at the border
+                    uint32_t maximumLength = recordLength;
+                    if(border) maximumLength = std::min<uint32_t>(maximumLength, border - recordAddress % border);
+                    qsizetype count = std::min<qsizetype>(maximumLength - length, data.size());
+                    memcpy(recordData + length, data.data(), count);
+                    length += count;
+                    data = data.sliced(count);
+                    if(length == maximumLength)
+                    {
+                        record(recordAddress, recordData, length);
+                        recordAddress += length;
+                        length = 0;
+                    }
+                }
+            },
+            [](uint64_t){});
+        if(length) record(recordAddress, recordData, length);
+    }
+}
+
+void HexFileParser::_parse(QByteArrayView data, LineParser lineParser, ReaderOutput &output) const
+{
+    uint32_t threadCount = _threadCount;
+    if(threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+        threadCount = std::min<qsizetype>(threadCount, data.size()/MIN_BYTES_PER_THREAD + 1);
+    }
+    // TI-TXT address lines apply to all following lines, such files are small and parsed in one go
+    if(lineParser == &HexFileParser::_parseTiTxtLine) threadCount = 1;
+
+    // Split at line ends
+    QList<QByteArrayView> ranges;
+    qsizetype rangeStart = 0;
+    for(uint32_t i = 1; i < threadCount && rangeStart < data.size(); i++)
+    {
+        qsizetype rangeEnd = std::max(rangeStart, data.size()*i/threadCount);
+        const char *lineEnd = static_cast<const char*>(memchr(data.data() + rangeEnd, '\n', data.size() - rangeEnd));
+        if(lineEnd == nullptr) break;
+
+        rangeEnd = lineEnd - data.data() + 1;
+        ranges.append(data.sliced(rangeStart, rangeEnd - rangeStart));
+        rangeStart = rangeEnd;
+    }
+    ranges.append(data.sliced(rangeStart));
+
+    QList<ParseContext> context(ranges.size());
+    if(ranges.size() == 1)
+    {
+        _parseRange(ranges.first(), context.first(), lineParser);
+    }
+    else if(lineParser == &HexFileParser::_parseIntelHexLine)
+    {
+        // The extended address at the start of a range comes from the last address record before it
+        struct LastAddress {
+            bool found;
+            uint32_t high16BitAddress;
+        };
+        QList<LastAddress> lastAddress(ranges.size());
+        std::vector<std::thread> threads;
+        for(qsizetype i = 0; i < ranges.size(); i++)
+        {
+            threads.emplace_back([&, i](){ lastAddress[i].found = _lastExtendedAddress(ranges.at(i), lastAddress[i].high16BitAddress); });
+        }
+        for(std::thread &thread: threads) thread.join();
+        threads.clear();
+
+        for(qsizetype i = 1; i < ranges.size(); i++)
+        {
+            context[i].high16BitAddress = lastAddress.at(i-1).found ? lastAddress.at(i-1).high16BitAddress : context.at(i-1).high16BitAddress;
+        }
+
+        for(qsizetype i = 0; i < ranges.size(); i++)
+        {
+            threads.emplace_back([&, i](){ _parseRange(ranges.at(i), context[i], lineParser); });
+        }
+        for(std::thread &thread: threads) thread.join();
+    }
+    else
+    {
+        // Every line holds its full address
+        std::vector<std::thread> threads;
+        for(qsizetype i = 0; i < ranges.size(); i++)
+        {
+            threads.emplace_back([&, i](){ _parseRange(ranges.at(i), context[i], lineParser); });
+        }
+        for(std::thread &thread: threads) thread.join();
+    }
+
+    _mergeContexts(context, output);
+}
+
+void HexFileParser::_mergeContexts(const QList<ParseContext> &context, ReaderOutput &output)
+{
+    // Merge in file order
+    QList<BinaryChunk> &binary = output.binary;
+    uint32_t lineOffset = 0;
+    for(const ParseContext &range: std::as_const(context))
+    {
+        for(FileError error: range.error){
+            error.lineIndex += lineOffset;
+            output.error.append(error);
+        }
+        for(FileError warning: range.warning){
+            warning.lineIndex += lineOffset;
+            output.warning.append(warning);
+        }
+        for(const BinaryChunk &chunk: range.binary){
+            if(!binary.isEmpty() && (uint64_t)binary.last().offset + binary.last().data.size() == chunk.offset){
+                binary.last().data.append(chunk.data);
+            }else{
+                binary.append(chunk);
+            }
+        }
+
+        if(output.fileAddress.minimum > range.fileAddress.minimum) output.fileAddress.minimum = range.fileAddress.minimum;
+        if(output.fileAddress.maximum < range.fileAddress.maximum) output.fileAddress.maximum = range.fileAddress.maximum;
+        lineOffset += range.lineCount;
+    }
+}
+
+#define PROGRESS_STEP (64*1024) // bytes parsed between progress updates of an asynchronous load
+
+void HexFileParser::_parseRange(QByteArrayView data, ParseContext &context, LineParser lineParser) const
+{
+    const char *position = data.data();
+    const char *end = position + data.size();
+    const char *reported = position;
+
+    while(position < end)
+    {
+        if(_loadState && position - reported >= PROGRESS_STEP){
+            _loadState->bytesProcessed += position - reported;
+            reported = position;
+            if(_loadState->canceled) return;
+        }
+
+        context.lineCount++;
+        const char *lineEnd = static_cast<const char*>(memchr(position, '\n', end - position));
+        if(lineEnd == nullptr) lineEnd = end;
+
+        // Trim whitespace and line endings
+        const char *lineStart = position;
+        const char *lineStop = lineEnd;
+        while(lineStart < lineStop && isspace((uint8_t)*lineStart)) lineStart++;
+        while(lineStop > lineStart && isspace((uint8_t)lineStop[-1])) lineStop--;
+
+        if(lineStop > lineStart) (this->*lineParser)(context, context.lineCount, lineStart, lineStop - lineStart);
+        position = lineEnd + 1;
+    }
+    if(_loadState) _loadState->bytesProcessed += std::min(position, end) - reported;
+}
+
+bool HexFileParser::_lastExtendedAddress(QByteArrayView data, uint32_t &high16BitAddress)
+{
+    // Walk the lines backwards, most ranges end shortly after an address record
+    const char *begin = data.data();
+    const char *lineEnd = data.data() + data.size();
+    while(lineEnd > begin)
+    {
+        const char *lineStart = lineEnd;
+        while(lineStart > begin && lineStart[-1] != '\n') lineStart--;
+
+        const char *line = lineStart;
+        while(line < lineEnd && isspace((uint8_t)*line)) line++;
+
+        if(lineEnd - line >= 15 && line[0] == ':' && decodeHexByte(&line[1]) == 2)
+        {
+            uint16_t recordType = decodeHexByte(&line[7]);
+            uint16_t high = decodeHexByte(&line[9]);
+            uint16_t low = decodeHexByte(&line[11]);
+            if(high <= 0xFF && low <= 0xFF)
+            {
+                if(recordType == (uint8_t)RecordType::ExtendedLinearAddress){
+                    high16BitAddress = ((uint32_t)high<<24) | ((uint32_t)low<<16);
+                    return true;
+                }
+                if(recordType == (uint8_t)RecordType::ExtendedSegmentAddress){
+                    high16BitAddress = (((uint32_t)high<<8) | low)<<4;
+                    return true;
+                }
+            }
+        }
+        lineEnd = lineStart > begin ? lineStart - 1 : begin;
+    }
+    return false;
+}
+
+void HexFileParser::_parseIntelHexLine(ParseContext &context, uint32_t lineIndex, const char *line, qsizetype length) const
+{
+    if(line[0] != ':')
+    {
+        context.error.append(FileError{lineIndex,ErrorType::InvalidStartCode});
+        return;
+    }
+
+    uint16_t lineByteCount = length >= 3 ? decodeHexByte(&line[1]) : 0x100;
+    if(lineByteCount > 0xFF || lineByteCount*2+11 != length){
+        context.error.append(FileError{lineIndex,ErrorType::InvalidLineLength});
+        return;
+    }
+
+    uint16_t lineRecordType = decodeHexByte(&line[7]);
+    if(lineRecordType > 0xFF){
+        context.error.append(FileError{lineIndex,ErrorType::InvalidRecordType});
+        return;
+    }
+
+    uint16_t lineAddressHighByte = decodeHexByte(&line[3]);
+    uint16_t lineAddressLowByte = decodeHexByte(&line[5]);
+    if(lineAddressHighByte > 0xFF || lineAddressLowByte > 0xFF){
+        context.error.append(FileError{lineIndex,ErrorType::InvalidAddressByte});
+        return;
+    }
+    uint16_t lineAddress = (lineAddressHighByte<<8) | lineAddressLowByte;
+
+    uint8_t lineData[255];
+    qsizetype invalidCharacter = decodeHex(&line[9], lineData, lineByteCount);
+    if(invalidCharacter >= 0){
+        context.error.append(FileError{lineIndex,ErrorType::InvalidDataByte,(uint32_t)(9+invalidCharacter+1)});
+        return;
+    }
+
+    uint8_t checksum = lineByteCount + lineRecordType + lineAddressHighByte+lineAddressLowByte;
+    checksum += Checksum::sum8(QByteArrayView(lineData, lineByteCount));
+    uint16_t lineChecksum = decodeHexByte(&line[length-2]);
+    checksum += lineChecksum;
+    if(lineChecksum > 0xFF || checksum != 0){
+        context.error.append(FileError{lineIndex,ErrorType::InvalidChecksum});
+        return;
+    }
+
+    switch ((RecordType)lineRecordType) {
+        case RecordType::Data:
+            _addData(context, lineIndex, context.high16BitAddress+lineAddress, lineData, lineByteCount);
+            break;
+
+        case RecordType::EndOfFile:
+            context.endOfFile = true;
+            return;
+
+        case RecordType::ExtendedLinearAddress:
+            if(lineByteCount < 2){
+                context.error.append(FileError{lineIndex,ErrorType::InvalidAddressByte});
+                return;
+            }
+            context.high16BitAddress = ((uint32_t)lineData[0]<<24) | ((uint32_t)lineData[1]<<16);
+            break;
+
+        case RecordType::ExtendedSegmentAddress:
+            if(lineByteCount < 2){
+                context.error.append(FileError{lineIndex,ErrorType::InvalidAddressByte});
+                return;
+            }
+            context.high16BitAddress = (((uint32_t)lineData[0]<<8) | lineData[1])<<4;
+            break;
+
+        case RecordType::StartLinearAddress:
+        case RecordType::StartSegmentAddress:
+            break;
+
+        default:
+            context.error.append(FileError{lineIndex,ErrorType::InvalidRecordType});
+            break;
+    }
+}
+
+void HexFileParser::_parseSRecordLine(ParseContext &context, uint32_t lineIndex, const char *line, qsizetype length) const
+{
+    if(line[0] != 'S')
+    {
+        context.error.append(FileError{lineIndex,ErrorType::InvalidStartCode});
+        return;
+    }
+
+    // Address bytes of S0 to S9, S4 is reserved
+    static const uint8_t addressLengths[10] = {2, 2, 3, 4, 0, 2, 3, 4, 3, 2};
+    if(length < 2 || line[1] < '0' || line[1] > '9' || line[1] == '4'){
+        context.error.append(FileError{lineIndex,ErrorType::InvalidRecordType});
+        return;
+    }
+    uint8_t recordType = line[1] - '0';
+    uint8_t addressLength = addressLengths[recordType];
+
+    // The byte count covers address, data and checksum
+    uint16_t byteCount = length >= 4 ? decodeHexByte(&line[2]) : 0x100;
+    if(byteCount > 0xFF || byteCount < addressLength + 1 || byteCount*2+4 != length){
+        context.error.append(FileError{lineIndex,ErrorType::InvalidLineLength});
+        return;
+    }
+
+    uint8_t lineData[255];
+    qsizetype invalidCharacter = decodeHex(&line[4], lineData, byteCount);
+    if(invalidCharacter >= 0){
+        if(invalidCharacter < addressLength*2) context.error.append(FileError{lineIndex,ErrorType::InvalidAddressByte});
+        else context.error.append(FileError{lineIndex,ErrorType::InvalidDataByte,(uint32_t)(4+invalidCharacter+1)});
+        return;
+    }
+
+    // One's complement checksum, all bytes including the checksum add up to 0xFF
+    uint8_t checksum = byteCount + Checksum::sum8(QByteArrayView(lineData, byteCount));
+    if(checksum != 0xFF){
+        context.error.append(FileError{lineIndex,ErrorType::InvalidChecksum});
+        return;
+    }
+
+    uint32_t address = 0;
+    for(uint8_t i = 0; i < addressLength; i++) address = (address << 8) | lineData[i];
+
+    switch(recordType){
+        case 1:
+        case 2:
+        case 3:
+            _addData(context, lineIndex, address, &lineData[addressLength], byteCount - addressLength - 1);
+            break;
+
+        default: // header, record count and start address
+            break;
+    }
+}
+
+#define ELF_PT_LOAD 1
+
+void HexFileParser::_parseElf(QByteArrayView data, ReaderOutput &output) const
+{
+    const uchar *file = reinterpret_cast<const uchar*>(data.data());
+    if(data.size() < 0x34 || memcmp(file, "\x7F" "ELF", 4) != 0 || (file[4] != 1 && file[4] != 2) || (file[5] != 1 && file[5] != 2)){
+        output.error.append(FileError{0,ErrorType::InvalidFileHeader});
+        return;
+    }
+    bool is64Bit = file[4] == 2;
+    bool isBigEndian = file[5] == 2;
+
+    auto read16 = [&](const uchar *value){ return isBigEndian ? qFromBigEndian<uint16_t>(value) : qFromLittleEndian<uint16_t>(value); };
+    auto read32 = [&](const uchar *value){ return isBigEndian ? qFromBigEndian<uint32_t>(value) : qFromLittleEndian<uint32_t>(value); };
+    auto read64 = [&](const uchar *value){ return isBigEndian ? qFromBigEndian<uint64_t>(value) : qFromLittleEndian<uint64_t>(value); };
+    auto readAddress = [&](const uchar *value){ return is64Bit ? read64(value) : (uint64_t)read32(value); };
+
+    // Program header table
+    if(is64Bit && data.size() < 0x40){
+        output.error.append(FileError{0,ErrorType::InvalidFileHeader});
+        return;
+    }
+    uint64_t headerOffset = readAddress(file + (is64Bit ? 0x20 : 0x1C));
+    uint16_t headerSize = read16(file + (is64Bit ? 0x36 : 0x2A));
+    uint16_t headerCount = read16(file + (is64Bit ? 0x38 : 0x2C));
+    if(headerSize < (is64Bit ? 0x38 : 0x20) || headerOffset > (uint64_t)data.size() || (uint64_t)headerSize*headerCount > data.size() - headerOffset){
+        output.error.append(FileError{0,ErrorType::InvalidFileHeader});
+        return;
+    }
+
+    for(uint16_t i = 0; i < headerCount; i++)
+    {
+        const uchar *header = file + headerOffset + (uint64_t)i*headerSize;
+        if(read32(header) != ELF_PT_LOAD) continue;
+
+        // The physical address is where the segment is programmed, like objcopy uses it for HEX files
+        uint64_t offset = readAddress(header + (is64Bit ? 0x08 : 0x04));
+        uint64_t address = readAddress(header + (is64Bit ? 0x18 : 0x0C));
+        uint64_t fileSize = readAddress(header + (is64Bit ? 0x20 : 0x10));
+        if(fileSize == 0) continue; // only memory, like .bss
+
+        if(offset > (uint64_t)data.size() || fileSize > data.size() - offset){
+            output.error.append(FileError{i,ErrorType::InvalidSegment});
+            continue;
+        }
+
+        uint64_t endAddress = address + fileSize - 1;
+        if(endAddress > 0xFFFFFFFF){
+            output.warning.append(FileError{i,ErrorType::AddressRangeTooHigh});
+            continue;
+        }
+
+        if(output.fileAddress.minimum > address) output.fileAddress.minimum = address;
+        if(output.fileAddress.maximum < endAddress) output.fileAddress.maximum = endAddress;
+
+        if(_memorySize.minimum > address) {
+            output.warning.append(FileError{i,ErrorType::AddressRangeTooLow});
+            continue;
+        }
+        if(_memorySize.maximum < endAddress) {
+            output.warning.append(FileError{i,ErrorType::AddressRangeTooHigh});
+            continue;
+        }
+
+        output.binary.append(BinaryChunk{(uint32_t)address, QByteArray::fromRawData(data.data() + offset, fileSize)});
+    }
+}
+
+void HexFileParser::_parseBinary(QByteArrayView data, ReaderOutput &output) const
+{
+    if(data.isEmpty()) return;
+
+    // Data behind the end of the memory size range is dropped
+    uint64_t size = std::min<uint64_t>(data.size(), (uint64_t)_memorySize.maximum - _memorySize.minimum + 1);
+    output.fileAddress = Range{_memorySize.minimum, (uint32_t)std::min<uint64_t>((uint64_t)_memorySize.minimum + data.size() - 1, 0xFFFFFFFF)};
+    if(size < (uint64_t)data.size()){
+        output.warning.append(FileError{0,ErrorType::AddressRangeTooHigh});
+    }
+    output.binary.append(BinaryChunk{_memorySize.minimum, QByteArray::fromRawData(data.data(), size)});
+}
+
+void HexFileParser::_parseTiTxtLine(ParseContext &context, uint32_t lineIndex, const char *line, qsizetype length) const
+{
+    if(line[0] == 'q' || line[0] == 'Q') return; // end of file
+
+    if(line[0] == '@')
+    {
+        if(length < 2 || length > 9){
+            context.error.append(FileError{lineIndex,ErrorType::InvalidAddressByte});
+            return;
+        }
+        uint32_t address = 0;
+        for(qsizetype i = 1; i < length; i++)
+        {
+            uint16_t digit = hexDigitTable[(uint8_t)line[i]];
+            if(digit > 0x0F){
+                context.error.append(FileError{lineIndex,ErrorType::InvalidAddressByte});
+                return;
+            }
+            address = (address << 4) | digit;
+        }
+        context.address = address;
+        return;
+    }
+
+    // Data bytes separated by white space
+    uint8_t lineData[255];
+    uint8_t count = 0;
+    for(qsizetype i = 0; i < length;)
+    {
+        if(isspace((uint8_t)line[i])){
+            i++;
+            continue;
+        }
+
+        uint16_t byte = i + 1 < length ? decodeHexByte(&line[i]) : 0x100;
+        if(byte > 0xFF || (i + 2 < length && !isspace((uint8_t)line[i+2]))){
+            uint32_t column = i + 1 < length && hexDigitTable[(uint8_t)line[i]] <= 0x0F ? i+2 : i+1;
+            context.error.append(FileError{lineIndex,ErrorType::InvalidDataByte,column});
+            return;
+        }
+        lineData[count++] = byte;
+        i += 2;
+
+        if(count == sizeof(lineData)){
+            _addData(context, lineIndex, context.address, lineData, count);
+            context.address += count;
+            count = 0;
+        }
+    }
+    if(count){
+        _addData(context, lineIndex, context.address, lineData, count);
+        context.address += count;
+    }
+}
+
+void HexFileParser::_addData(ParseContext &context, uint32_t lineIndex, uint32_t address, const uint8_t *data, uint8_t length) const
+{
+    uint32_t lineStartAddress = address;
+    uint32_t lineEndAddress = address + length-1;
+
+    if(context.fileAddress.minimum > lineStartAddress) context.fileAddress.minimum = lineStartAddress;
+    if(context.fileAddress.maximum < lineEndAddress) context.fileAddress.maximum = lineEndAddress;
+
+    if(_memorySize.minimum > lineStartAddress) {
+        context.warning.append(FileError{lineIndex,ErrorType::AddressRangeTooLow});
+        return;
+    }
+
+    if(_memorySize.maximum < lineEndAddress) {
+        context.warning.append(FileError{lineIndex,ErrorType::AddressRangeTooHigh});
+        return;
+    }
+
+    // Consecutive records are collected in one chunk instead of one chunk per line
+    if(!context.binary.isEmpty() && (uint64_t)context.binary.last().offset + context.binary.last().data.size() == lineStartAddress){
+        context.binary.last().data.append(reinterpret_cast<const char*>(data), length);
+    }else{
+        context.binary.append(BinaryChunk{lineStartAddress, QByteArray(reinterpret_cast<const char*>(data), length)});
+    }
+}
+
+void HexFileParser::_combineBinaryChunks(QList<BinaryChunk> binary)
+{
+    _image.clear();
+    if(binary.empty()){
+        _updateBinaryAddressRange();
+        _updateCrcCache();
+        return;
+    }
+
+    std::sort(binary.begin(), binary.end(), [](const BinaryChunk &a, const BinaryChunk &b){ return a.offset < b.offset; } );
+
+    // Sizing pass: chunks separated by no more than the gap size end up in the same output chunk,
+    // as do chunks whose aligned ranges overlap or touch, so the fill of one never overwrites data of another
+    struct Group {
+        qsizetype first;
+        qsizetype last;
+        uint64_t end;
+        uint64_t alignedStart;
+        uint64_t alignedEnd;
+    };
+    uint64_t alignment = std::max(1u, _addressAlignment);
+    QList<Group> groups;
+    for(qsizetype i = 0; i < binary.size(); i++)
+    {
+        uint64_t start = binary.at(i).offset;
+        uint64_t end = start + binary.at(i).data.length();
+        uint64_t alignedStart = start - start % alignment;
+        uint64_t alignedEnd = std::min<uint64_t>((end + alignment - 1) / alignment * alignment, 0x100000000);
+        if(!groups.isEmpty() && (start <= groups.last().end + _addressGapSize || alignedStart <= groups.last().alignedEnd)){
+            groups.last().last = i;
+            groups.last().end = std::max(groups.last().end, end);
+            groups.last().alignedEnd = std::max(groups.last().alignedEnd, alignedEnd);
+        }else{
+            groups.append(Group{i, i, end, alignedStart, alignedEnd});
+        }
+    }
+
+    // One allocation per output chunk, gaps and alignment are filled in bulk
+    for(const Group &group: std::as_const(groups))
+    {
+        uint64_t alignedStart = group.alignedStart;
+        uint64_t alignedEnd = group.alignedEnd;
+
+        QByteArray data(alignedEnd - alignedStart, Qt::Uninitialized);
+        char *output = data.data();
+        uint64_t position = alignedStart;
+        for(qsizetype i = group.first; i <= group.last; i++)
+        {
+            const BinaryChunk &chunk = binary.at(i);
+            if(chunk.offset > position) memset(output + (position - alignedStart), _fillValue, chunk.offset - position);
+            memcpy(output + (chunk.offset - alignedStart), chunk.data.constData(), chunk.data.length());
+            position = std::max<uint64_t>(position, (uint64_t)chunk.offset + chunk.data.length());
+        }
+        memset(output + (position - alignedStart), _fillValue, alignedEnd - position);
+
+        _image.write(alignedStart, data);
     }
 
-    return BinaryChunk{alignedOffset, data};
+    _updateBinaryAddressRange();
+    _updateCrcCache();
 }
@@ -4,8 +4,16 @@
 #define HexFileParser_H
 
 #include <QByteArray>
+#include <QByteArrayView>
 #include <QString>
 #include <QFile>
+#include <QIODevice>
+#include <QMap>
+#include <functional>
+#include <atomic>
+#include <future>
+#include <memory>
+#include "memoryImage.h"
 
 namespace QuCLib {
 
@@ -23,29 +31,80 @@ class HexFileParser
             InvalidAddressByte,
             InvalidDataByte,
             AddressRangeTooLow,
-            AddressRangeTooHigh
+            AddressRangeTooHigh,
+            InvalidFileHeader,
+            InvalidSegment,
+            Canceled
         };
 
         struct FileError {
-            uint32_t lineIndex;
+            uint32_t lineIndex; // program header index for ELF files
             ErrorType error;
+            uint32_t column = 0; // character in the line, starting at 1, 0 if not known
         };
 
-        struct BinaryChunk {
-            uint32_t offset;
-            QByteArray data;
+        typedef MemoryImage::Chunk BinaryChunk;
+
+        typedef MemoryImage::Range Range;
+
+        // Result of a file reader, the chunks may point into the file data as they are copied into the image before the file is closed
+        struct ReaderOutput {
+            QList<BinaryChunk> binary;
+            QList<FileError> error;
+            QList<FileError> warning;
+            Range fileAddress = {0xFFFFFFFF, 0};
         };
 
-        struct Range {
-            uint32_t minimum;
-            uint32_t maximum;
+        // A file format for loadAutoDetect(), probe gets the first bytes of the file
+        struct FileReader {
+            QString name;
+            std::function<bool(QByteArrayView head)> probe;
+            std::function<void(const HexFileParser &parser, QByteArrayView data, ReaderOutput &output)> parse;
         };
 
 
         HexFileParser(void);
 
         bool load(QString filePath);
+        // Intel HEX from memory, or read from an open device line by line as the data arrives
+        bool load(QByteArrayView data);
+        bool load(QIODevice &device);
+        // Writes Intel HEX with extended linear address records, records don't cross 64 KiB borders
         bool saveToFile(QString filePath);
+
+        // Motorola S-record (.s19, .s28, .s37), the address size of the saved file fits the highest address
+        bool loadSRecord(QString filePath);
+        bool saveToSRecordFile(QString filePath);
+
+        // Loads the file bytes of the PT_LOAD segments at their physical address, 32/64-bit and either endianness
+        bool loadElf(QString filePath);
+
+        // TI-TXT as written by the MSP430 tools
+        bool loadTiTxt(QString filePath);
+        // Raw binary, loaded at the start of the memory size range
+        bool loadBinary(QString filePath);
+
+        // Picks the reader from the first bytes of the file, files no reader recognizes are loaded as binary
+        bool loadAutoDetect(QString filePath);
+        // Name of the reader used by the last load
+        const QString &fileFormat(void) const;
+
+        // Registered readers are probed before the built-in ones, register them before loading files on other threads
+        static void registerReader(const FileReader &reader);
+        // Removes the registered readers with this name, built-in readers stay
+        static bool unregisterReader(const QString &name);
+        static QList<FileReader> readers(void);
+
+        // Writes a binary cache of the loaded image next to the file, later loads map the cache
+        // instead of parsing the file while the file and the parser settings are unchanged
+        void setLoadCacheEnabled(bool enabled);
+        static QString cacheFilePath(const QString &filePath);
+
+        // Loads on a worker thread with a copy of this parser's settings, e.g. loadAsync(path, &HexFileParser::loadSRecord).
+        // Every task has its own thread, several files load concurrently.
+        class LoadTask;
+        LoadTask loadAsync(QString filePath, bool (HexFileParser::*load)(QString) = &HexFileParser::load) const;
+
         void clear(void);
 
         // data outside of the MemorySize range will be discarded
@@ -55,10 +114,85 @@ class HexFileParser
         void setAddressGapSize(uint32_t gap);
         void setAddressAlignment(uint32_t alignment);
 
+        // Data bytes per record written by saveToFile, 16 by default
+        void setRecordLength(uint8_t length);
+
+        // Storage::Pages suits images spread over the whole address space, the loaded data is kept
+        void setImageStorage(MemoryImage::Storage storage);
+
+        // Large files are split into line aligned ranges that are parsed in parallel, 0 uses all cores
+        void setThreadCount(uint32_t count);
+
+        // Time load(QIODevice&) waits for more data from a sequential device, 30 s by default.
+        // Reading stops at the end of file record without waiting.
+        void setStreamTimeout(int milliseconds);
+
+        // Reads across chunk borders, addresses without data read as fill value
         QByteArray extract(uint32_t address, uint32_t size);
+        // Same as extract(), without copying if the range lies in one chunk. The view then points into the image and is valid
+        // until the image is modified, otherwise the range is assembled in buffer, whose allocation is reused by later calls.
+        QByteArrayView extractView(uint32_t address, uint32_t size, QByteArray &buffer) const;
+        // Calls data with views into the image and fill for the gaps, in address order
+        void extract(uint32_t address, uint32_t size, const std::function<void(QByteArrayView)> &data, const std::function<void(uint64_t)> &fill) const;
+        // Flash memory layout for forEachPage()
+        struct FlashGeometry {
+            QList<Range> sectors; // erase sectors in address order, their sizes are multiples of the page size
+            uint32_t pageSize = 256; // program page
+            uint8_t erasedValue = 0xFF;
+
+            // sectorCount sectors of sectorSize bytes starting at address
+            static FlashGeometry uniform(uint32_t address, uint32_t sectorSize, uint32_t sectorCount, uint32_t pageSize = 256, uint8_t erasedValue = 0xFF);
+        };
+
+        struct FlashPage {
+            uint32_t address;
+            qsizetype sector; // index in FlashGeometry::sectors
+            QByteArrayView data; // addresses without data read as the erased value, valid during the call only
+            bool blank; // all bytes are the erased value, programming the page can be skipped
+        };
+
+        // Calls page for every page of the sectors that holds loaded data, in address order, without allocating per page.
+        // Stops and returns false when page returns false.
+        bool forEachPage(const FlashGeometry &geometry, const std::function<bool(const FlashPage &page)> &page) const;
+
+        // Erasing a sector clears all its pages, so every non-blank page of a changed sector is programmed again
+        struct FlashUpdate {
+            QList<qsizetype> sectors; // sectors to erase, indices in FlashGeometry::sectors
+            QList<BinaryChunk> pages; // pages to program after the erase
+            qsizetype changedPages = 0; // pages whose content differs
+        };
+
+        // Compares the flash content, given as the image on the device or as a readback of the flash starting at address,
+        // with every page that holds data in this image or on the device. Addresses without data count as erased.
+        FlashUpdate diff(const HexFileParser &device, const FlashGeometry &geometry) const;
+        FlashUpdate diff(uint32_t address, const QByteArray &readback, const FlashGeometry &geometry) const;
+
+        enum class FlashHash {
+            Crc32, // as crc32()
+            Crc32c,
+            Crc32Stm32 // as crc32Stm32()
+        };
+
+        // One hash per sector, or per page of every sector, in address order. Addresses without data count as the erased value.
+        // The blocks are hashed in parallel, see setThreadCount().
+        QList<uint32_t> hashManifest(const FlashGeometry &geometry, FlashHash hash = FlashHash::Crc32, bool perPage = false) const;
+        // Indices of the entries that differ from the manifest reported by the device, missing entries count as different
+        static QList<qsizetype> compareManifest(const QList<uint32_t> &manifest, const QList<uint32_t> &deviceManifest);
+
+        // Writes into the image, data that overlaps or touches existing chunks is merged with them
         void replace(uint32_t address, QByteArray data);
         void insert(const BinaryChunk &data);
 
+        // CRC32 of the address range, gaps between chunks are calculated as fill value
+        uint32_t crc32(uint32_t address, uint32_t size) const;
+        // CRC as calculated by the STM32 CRC unit over 32-bit words, see Crc::crc32Stm32
+        uint32_t crc32Stm32(uint32_t address, uint32_t size) const;
+
+        // Keeps a CRC32 per chunk that replace() updates with the changed bytes only
+        void setCrcCacheEnabled(bool enabled);
+        // CRC32 of the binary address range, gaps are calculated as fill value
+        uint32_t imageCrc32(void) const;
+
         const Range &fileAddressRange(void) const;
         const Range &binaryAddressRange(void) const;
         const Range &memoryAddressRange(void) const;
@@ -90,18 +224,107 @@ class HexFileParser
         uint32_t _addressAlignment;
         uint8_t _fillValue;
 
-        void _parseLine(uint32_t lineIndex, QString line);
-        void _combineBinaryChunks(void);
+        // Parser state and output of one range of lines
+        struct ParseContext {
+            uint32_t high16BitAddress = 0;
+            uint32_t address = 0; // next data address in TI-TXT files
+            uint32_t lineCount = 0;
+            bool endOfFile = false; // end of file record parsed
+            Range fileAddress = {0xFFFFFFFF, 0};
+            QList<BinaryChunk> binary;
+            QList<FileError> error;
+            QList<FileError> warning;
+        };
+
+        uint32_t _threadCount;
+        uint8_t _recordLength;
+        int _streamTimeout;
+
+        typedef void (HexFileParser::*LineParser)(ParseContext &context, uint32_t lineIndex, const char *line, qsizetype length) const;
+
+        enum BuiltInReader {
+            ElfReader,
+            IntelHexReader,
+            SRecordReader,
+            TiTxtReader,
+            BinaryReader
+        };
+        static const QList<FileReader> &_builtInReaders(void);
+        QString _fileFormat;
+
+        bool _loadFile(QString filePath, const QList<FileReader> &readers);
+        // Probes the readers in order if there is more than one
+        bool _loadData(QByteArrayView data, const QList<FileReader> &readers);
+        void _startLoad(void);
+        bool _finishLoad(const ReaderOutput &output);
+        void _parse(QByteArrayView data, LineParser lineParser, ReaderOutput &output) const;
+        static void _mergeContexts(const QList<ParseContext> &context, ReaderOutput &output);
 
-        BinaryChunk _fixChunkAddressAlignment(uint32_t offset, QByteArray data);
+        // Shared with the LoadTask of an asynchronous load
+        struct LoadState {
+            std::atomic<qint64> bytesProcessed{0};
+            std::atomic<qint64> bytesTotal{0};
+            std::atomic<bool> canceled{false};
+        };
+        LoadState *_loadState = nullptr; // set on the worker's parser only
 
-        uint32_t _high16BitAddress;
+        bool _loadCacheEnabled;
+        bool _loadCache(const QString &filePath, const QList<FileReader> &readers);
+        void _saveCache(const QString &filePath, QByteArrayView source) const;
+        void _parseRange(QByteArrayView data, ParseContext &context, LineParser lineParser) const;
+        void _parseIntelHexLine(ParseContext &context, uint32_t lineIndex, const char *line, qsizetype length) const;
+        void _parseSRecordLine(ParseContext &context, uint32_t lineIndex, const char *line, qsizetype length) const;
+        void _parseTiTxtLine(ParseContext &context, uint32_t lineIndex, const char *line, qsizetype length) const;
+        void _parseElf(QByteArrayView data, ReaderOutput &output) const;
+        void _parseBinary(QByteArrayView data, ReaderOutput &output) const;
+        void _addData(ParseContext &context, uint32_t lineIndex, uint32_t address, const uint8_t *data, uint8_t length) const;
+        static bool _lastExtendedAddress(QByteArrayView data, uint32_t &high16BitAddress);
+        void _combineBinaryChunks(QList<BinaryChunk> binary);
 
-        QList<BinaryChunk> _binary;
+        // Splits the loaded data into records of up to recordLength bytes that don't cross a multiple of border, 0 for none
+        void _forEachRecord(uint8_t recordLength, uint32_t border, const std::function<void(uint32_t address, const uint8_t *data, uint8_t length)> &record) const;
+
+        bool _crcCacheEnabled;
+        QMap<uint32_t, uint32_t> _chunkCrc; // CRC32 of each chunk by chunk offset, if the cache is enabled
+        void _updateCrcCache(void);
+        void _updateChunkCrc(const Range &chunk);
+
+        void _updateBinaryAddressRange(void);
+
+        uint32_t _crc(FlashHash hash, uint32_t address, uint32_t size, uint8_t fillValue) const;
+
+        // The range as a view into the image if it is stored in one piece, otherwise assembled in buffer
+        static QByteArrayView _view(const MemoryImage &image, uint32_t address, uint32_t size, uint8_t fillValue, QByteArray &buffer);
+        FlashUpdate _diff(const MemoryImage &device, const FlashGeometry &geometry) const;
+        // Pages of the sectors that overlap ranges, which are sorted and don't overlap
+        bool _forEachPage(const QList<Range> &ranges, const FlashGeometry &geometry, const std::function<bool(const FlashPage &page)> &page) const;
+
+        MemoryImage _image;
         QList<FileError> _error;
         QList<FileError> _warning;
+};
 
-        uint8_t _calculateChecksum(QByteArray data);
+// Progress and result of HexFileParser::loadAsync(), copies refer to the same load.
+// Destroying the last copy waits for the load, call cancel() first to stop it early.
+class HexFileParser::LoadTask
+{
+    public:
+        // Stops parsing at the next block of lines, the result then holds a Canceled error
+        void cancel(void);
+        bool isFinished(void) const;
+
+        // Bytes of the file parsed so far and the file size, updated while the load runs
+        qint64 bytesProcessed(void) const;
+        qint64 bytesTotal(void) const;
+
+        // Waits for the load, the parser holds the image or the errors
+        const HexFileParser &result(void) const;
+        std::shared_future<HexFileParser> future(void) const;
+
+    private:
+        friend class HexFileParser;
+        std::shared_ptr<LoadState> _state;
+        std::shared_future<HexFileParser> _result;
 };
 
 }
@@ -0,0 +1,378 @@
+#include "memoryImage.h"
+#include <cstring>
+#include <iterator>
+
+using namespace QuCLib;
+
+#define ADDRESS_SPACE_END 0x100000000
+#define PAGE_TABLE_SIZE 1024 // entries per level, 1024 * 1024 pages of 4 KiB cover 4 GiB
+
+MemoryImage::MemoryImage(Storage storage)
+    : _storage(storage)
+{
+}
+
+MemoryImage::Storage MemoryImage::storage() const
+{
+    return _storage;
+}
+
+void MemoryImage::clear()
+{
+    _chunks.clear();
+    _ranges.clear();
+    _pageTable.clear();
+}
+
+bool MemoryImage::isEmpty() const
+{
+    if(_storage == Storage::Pages) return _ranges.isEmpty();
+    return _chunks.isEmpty();
+}
+
+qsizetype MemoryImage::chunkCount() const
+{
+    if(_storage == Storage::Pages) return _ranges.size();
+    return _chunks.size();
+}
+
+QList<MemoryImage::Chunk> MemoryImage::chunks() const
+{
+    QList<Chunk> output;
+    output.reserve(chunkCount());
+    if(_storage == Storage::Pages)
+    {
+        for(const Range &range: ranges())
+        {
+            output.append(Chunk{range.minimum, read(range.minimum, range.maximum - range.minimum + 1, 0x00)});
+        }
+        return output;
+    }
+
+    for(ChunkMap::const_iterator chunk = _chunks.cbegin(); chunk != _chunks.cend(); ++chunk)
+    {
+        output.append(Chunk{chunk.key(), chunk.value()});
+    }
+    return output;
+}
+
+QList<MemoryImage::Range> MemoryImage::ranges() const
+{
+    QList<Range> output;
+    output.reserve(chunkCount());
+    if(_storage == Storage::Pages)
+    {
+        for(QMap<uint32_t, uint32_t>::const_iterator range = _ranges.cbegin(); range != _ranges.cend(); ++range)
+        {
+            output.append(Range{range.key(), range.value()});
+        }
+        return output;
+    }
+
+    for(ChunkMap::const_iterator chunk = _chunks.cbegin(); chunk != _chunks.cend(); ++chunk)
+    {
+        output.append(Range{chunk.key(), (uint32_t)(_chunkEnd(chunk) - 1)});
+    }
+    return output;
+}
+
+uint32_t MemoryImage::firstAddress() const
+{
+    if(_storage == Storage::Pages) return _ranges.firstKey();
+    return _chunks.firstKey();
+}
+
+uint32_t MemoryImage::lastAddress() const
+{
+    if(_storage == Storage::Pages) return _ranges.last();
+    return _chunks.lastKey() + _chunks.last().size() - 1;
+}
+
+bool MemoryImage::rangeAt(uint32_t address, Range &range) const
+{
+    if(_storage == Storage::Pages)
+    {
+        QMap<uint32_t, uint32_t>::const_iterator entry = _ranges.upperBound(address);
+        if(entry == _ranges.cbegin()) return false;
+        --entry;
+        if(entry.value() < address) return false;
+
+        range = Range{entry.key(), entry.value()};
+        return true;
+    }
+
+    ChunkMap::const_iterator chunk = _findChunk(address);
+    if(chunk == _chunks.cend()) return false;
+
+    range = Range{chunk.key(), (uint32_t)(_chunkEnd(chunk) - 1)};
+    return true;
+}
+
+MemoryImage::Range MemoryImage::write(uint32_t address, QByteArrayView data)
+{
+    if(data.isEmpty()) return Range{address, address};
+
+    if((uint64_t)address + data.size() > ADDRESS_SPACE_END) data = data.first(ADDRESS_SPACE_END - address);
+
+    if(_storage == Storage::Pages)
+    {
+        _writePages(address, data);
+        return _mergeRange(address, address + data.size() - 1);
+    }
+    return _writeChunk(address, data);
+}
+
+MemoryImage::Range MemoryImage::write(uint32_t address, const QByteArray &data)
+{
+    uint64_t end = (uint64_t)address + data.size();
+    if(_storage == Storage::Chunks && !data.isEmpty() && end <= ADDRESS_SPACE_END)
+    {
+        ChunkMap::const_iterator next = _chunks.upperBound(address);
+        bool touchesPrevious = next != _chunks.cbegin() && _chunkEnd(std::prev(next)) >= address;
+        bool touchesNext = next != _chunks.cend() && next.key() <= end;
+        if(!touchesPrevious && !touchesNext)
+        {
+            _chunks.insert(address, data);
+            return Range{address, (uint32_t)(end - 1)};
+        }
+    }
+    return write(address, QByteArrayView(data));
+}
+
+bool MemoryImage::overwrite(uint32_t address, QByteArrayView data)
+{
+    if(!contains(address, data.size())) return false;
+
+    if(_storage == Storage::Pages)
+    {
+        _writePages(address, data);
+        return true;
+    }
+
+    ChunkMap::const_iterator chunk = _findChunk(address);
+    QByteArray &chunkData = _chunks[chunk.key()];
+    memcpy(chunkData.data() + (address - chunk.key()), data.data(), data.size());
+    return true;
+}
+
+QByteArray MemoryImage::read(uint32_t address, uint32_t size, uint8_t fillValue) const
+{
+    if(_storage == Storage::Chunks)
+    {
+        ChunkMap::const_iterator chunk = _findChunk(address);
+        if(chunk != _chunks.cend() && _chunkEnd(chunk) >= (uint64_t)address + size)
+        {
+            return chunk.value().mid(address - chunk.key(), size);
+        }
+    }
+
+    QByteArray output;
+    output.reserve(size);
+    walk(address, size,
+        [&](QByteArrayView data){ output.append(data.data(), data.size()); },
+        [&](uint64_t count){ output.append(count, (char)fillValue); });
+    return output;
+}
+
+bool MemoryImage::contains(uint32_t address, uint32_t size) const
+{
+    if(size == 0) return true;
+
+    // Touching ranges are merged, so a loaded range is always inside one of them
+    Range range;
+    return rangeAt(address, range) && (uint64_t)range.maximum + 1 >= (uint64_t)address + size;
+}
+
+bool MemoryImage::view(uint32_t address, uint32_t size, QByteArrayView &data) const
+{
+    if(size == 0)
+    {
+        data = QByteArrayView();
+        return true;
+    }
+
+    if(_storage == Storage::Pages)
+    {
+        if(address % pageSize + (uint64_t)size > pageSize || !contains(address, size)) return false;
+        data = QByteArrayView(_page(address) + address % pageSize, size);
+        return true;
+    }
+
+    ChunkMap::const_iterator chunk = _findChunk(address);
+    if(chunk == _chunks.cend() || _chunkEnd(chunk) < (uint64_t)address + size) return false;
+
+    data = QByteArrayView(chunk.value()).sliced(address - chunk.key(), size);
+    return true;
+}
+
+void MemoryImage::walk(uint32_t address, uint32_t size, const std::function<void (QByteArrayView)> &data, const std::function<void (uint64_t)> &fill) const
+{
+    uint64_t position = address;
+    uint64_t end = (uint64_t)address + size;
+
+    if(_storage == Storage::Pages)
+    {
+        QMap<uint32_t, uint32_t>::const_iterator range = _ranges.upperBound(address);
+        if(range != _ranges.cbegin() && std::prev(range).value() >= address) --range;
+
+        for(; range != _ranges.cend() && range.key() < end; ++range)
+        {
+            if(range.key() > position)
+            {
+                fill(range.key() - position);
+                position = range.key();
+            }
+
+            uint64_t dataEnd = std::min<uint64_t>((uint64_t)range.value() + 1, end);
+            while(position < dataEnd)
+            {
+                uint32_t pageOffset = position % pageSize;
+                uint64_t length = std::min<uint64_t>(pageSize - pageOffset, dataEnd - position);
+                data(QByteArrayView(_page(position) + pageOffset, length));
+                position += length;
+            }
+        }
+    }
+    else
+    {
+        for(ChunkMap::const_iterator chunk = _lowerBound(address); chunk != _chunks.cend(); ++chunk)
+        {
+            uint64_t chunkStart = chunk.key();
+            if(chunkStart >= end) break;
+
+            if(chunkStart > position)
+            {
+                fill(chunkStart - position);
+                position = chunkStart;
+            }
+
+            uint64_t dataEnd = std::min(_chunkEnd(chunk), end);
+            data(QByteArrayView(chunk.value()).sliced(position - chunkStart, dataEnd - position));
+            position = dataEnd;
+        }
+    }
+
+    if(position < end)
+    {
+        fill(end - position);
+    }
+}
+
+MemoryImage::ChunkMap::const_iterator MemoryImage::_lowerBound(uint32_t address) const
+{
+    ChunkMap::const_iterator chunk = _chunks.upperBound(address);
+    if(chunk != _chunks.cbegin())
+    {
+        ChunkMap::const_iterator previous = std::prev(chunk);
+        if(_chunkEnd(previous) > address) return previous;
+    }
+    return chunk;
+}
+
+MemoryImage::ChunkMap::const_iterator MemoryImage::_findChunk(uint32_t address) const
+{
+    ChunkMap::const_iterator chunk = _lowerBound(address);
+    if(chunk != _chunks.cend() && chunk.key() <= address) return chunk;
+    return _chunks.cend();
+}
+
+MemoryImage::Range MemoryImage::_writeChunk(uint32_t address, QByteArrayView data)
+{
+    uint64_t start = address;
+    uint64_t end = start + data.size();
+
+    // Chunks from first up to last overlap or touch the new data
+    ChunkMap::iterator first = _chunks.upperBound(address);
+    if(first != _chunks.begin() && _chunkEnd(std::prev(first)) >= start) --first;
+    ChunkMap::iterator last = first;
+    while(last != _chunks.end() && last.key() <= end) ++last;
+
+    if(first == last)
+    {
+        _chunks.insert(address, data.toByteArray());
+        return Range{address, (uint32_t)(end - 1)};
+    }
+
+    // Tail of the last merged chunk that lies behind the new data
+    QByteArrayView tail;
+    ChunkMap::const_iterator lastChunk = std::prev(last);
+    if(_chunkEnd(lastChunk) > end) tail = QByteArrayView(lastChunk.value()).sliced(end - lastChunk.key());
+
+    if(first.key() <= start)
+    {
+        // Grow the first chunk in place, appending to a chunk is the common case when an image is written in order
+        QByteArray &chunk = first.value();
+        qsizetype index = start - first.key();
+        if(chunk.size() < index + data.size()) chunk.resize(index + data.size());
+        memcpy(chunk.data() + index, data.data(), data.size());
+        if(lastChunk != ChunkMap::const_iterator(first)) chunk.append(tail.data(), tail.size());
+
+        _chunks.erase(std::next(first), last);
+        return Range{first.key(), (uint32_t)(_chunkEnd(first) - 1)};
+    }
+
+    QByteArray chunk = data.toByteArray();
+    chunk.append(tail.data(), tail.size());
+    _chunks.erase(first, last);
+    _chunks.insert(address, chunk);
+    return Range{address, (uint32_t)(start + chunk.size() - 1)};
+}
+
+uint64_t MemoryImage::_chunkEnd(ChunkMap::const_iterator chunk)
+{
+    return (uint64_t)chunk.key() + chunk.value().size();
+}
+
+const char *MemoryImage::_page(uint32_t address) const
+{
+    uint32_t pageIndex = address / pageSize;
+    if(_pageTable.isEmpty()) return nullptr;
+    const QList<QByteArray> &table = _pageTable.at(pageIndex / PAGE_TABLE_SIZE);
+    if(table.isEmpty()) return nullptr;
+    const QByteArray &page = table.at(pageIndex % PAGE_TABLE_SIZE);
+    return page.isNull() ? nullptr : page.constData();
+}
+
+void MemoryImage::_writePages(uint32_t address, QByteArrayView data)
+{
+    if(_pageTable.isEmpty()) _pageTable.resize(PAGE_TABLE_SIZE);
+
+    uint64_t position = address;
+    while(!data.isEmpty())
+    {
+        uint32_t pageIndex = position / pageSize;
+        QList<QByteArray> &table = _pageTable[pageIndex / PAGE_TABLE_SIZE];
+        if(table.isEmpty()) table.resize(PAGE_TABLE_SIZE);
+        QByteArray &page = table[pageIndex % PAGE_TABLE_SIZE];
+        if(page.isNull()) page = QByteArray(pageSize, '\0');
+
+        // data() detaches the page if it is shared with a copy of the image
+        uint32_t pageOffset = position % pageSize;
+        qsizetype length = std::min<qsizetype>(pageSize - pageOffset, data.size());
+        memcpy(page.data() + pageOffset, data.data(), length);
+
+        data = data.sliced(length);
+        position += length;
+    }
+}
+
+MemoryImage::Range MemoryImage::_mergeRange(uint32_t minimum, uint32_t maximum)
+{
+    // Ranges from first up to last overlap or touch the new one
+    QMap<uint32_t, uint32_t>::iterator first = _ranges.upperBound(minimum);
+    if(first != _ranges.begin() && (uint64_t)std::prev(first).value() + 1 >= minimum) --first;
+    QMap<uint32_t, uint32_t>::iterator last = first;
+    while(last != _ranges.end() && last.key() <= (uint64_t)maximum + 1)
+    {
+        maximum = std::max(maximum, last.value());
+        ++last;
+    }
+
+    if(first != last)
+    {
+        minimum = std::min(minimum, first.key());
+        _ranges.erase(first, last);
+    }
+    _ranges.insert(minimum, maximum);
+    return Range{minimum, maximum};
+}
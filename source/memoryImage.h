@@ -0,0 +1,91 @@
+#ifndef MEMORYIMAGE_H
+#define MEMORYIMAGE_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QMap>
+#include <functional>
+
+namespace QuCLib {
+
+// Sparse memory image of a 32-bit address space. Loaded data is kept as non overlapping ranges,
+// ranges that touch or overlap are merged on write.
+class MemoryImage
+{
+
+public:
+    enum class Storage {
+        Chunks, // one buffer per loaded range in an ordered map, O(log n) lookup
+        Pages // lazily allocated two-level table of 4 KiB pages, O(1) lookup, pages are copied on first write
+    };
+
+    struct Chunk {
+        uint32_t offset;
+        QByteArray data;
+    };
+
+    struct Range {
+        uint32_t minimum;
+        uint32_t maximum;
+    };
+
+    static constexpr uint32_t pageSize = 4096;
+
+    explicit MemoryImage(Storage storage = Storage::Chunks);
+    Storage storage(void) const;
+
+    void clear(void);
+    bool isEmpty(void) const;
+    qsizetype chunkCount(void) const;
+    // Loaded ranges in address order, chunks() copies the data of each range
+    QList<Chunk> chunks(void) const;
+    QList<Range> ranges(void) const;
+
+    // First and last address that holds data, only valid if the image is not empty
+    uint32_t firstAddress(void) const;
+    uint32_t lastAddress(void) const;
+
+    // Loaded range that holds address, returns false if the address is not loaded
+    bool rangeAt(uint32_t address, Range &range) const;
+
+    // Writes data to the image, returns the loaded range that holds the data afterwards
+    Range write(uint32_t address, QByteArrayView data);
+    // Same as above, a chunk that touches no other chunk shares the data instead of copying it
+    Range write(uint32_t address, const QByteArray &data);
+    // Writes data only if the whole range is loaded
+    bool overwrite(uint32_t address, QByteArrayView data);
+
+    // Reads the range across chunk borders, addresses that are not loaded read as fillValue
+    QByteArray read(uint32_t address, uint32_t size, uint8_t fillValue) const;
+    // True if every address of the range is loaded
+    bool contains(uint32_t address, uint32_t size) const;
+    // The range without copying if it is stored in one piece: inside one chunk, or inside one page for Storage::Pages.
+    // The view is valid until the image is modified, returns false if the range is not loaded or not in one piece.
+    bool view(uint32_t address, uint32_t size, QByteArrayView &data) const;
+
+    // Calls data for the loaded bytes and fill for the gaps in the address range, in address order.
+    // The views point into the image and are valid until it is modified.
+    void walk(uint32_t address, uint32_t size, const std::function<void(QByteArrayView)> &data, const std::function<void(uint64_t)> &fill) const;
+
+private:
+    Storage _storage;
+
+    typedef QMap<uint32_t, QByteArray> ChunkMap;
+    ChunkMap _chunks; // Storage::Chunks, data by offset
+
+    QMap<uint32_t, uint32_t> _ranges; // Storage::Pages, maximum by minimum of each loaded range
+    QList<QList<QByteArray>> _pageTable; // Storage::Pages, 1024 entries of 1024 pages, allocated on first write
+
+    ChunkMap::const_iterator _lowerBound(uint32_t address) const;
+    ChunkMap::const_iterator _findChunk(uint32_t address) const;
+    Range _writeChunk(uint32_t address, QByteArrayView data);
+    static uint64_t _chunkEnd(ChunkMap::const_iterator chunk);
+
+    const char *_page(uint32_t address) const;
+    void _writePages(uint32_t address, QByteArrayView data);
+    Range _mergeRange(uint32_t minimum, uint32_t maximum);
+};
+
+};
+#endif // MEMORYIMAGE_H
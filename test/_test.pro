@@ -1,7 +1,7 @@
 TEMPLATE = app
 QT += gui
 
-CONFIG += c++11
+CONFIG += c++17
 
 isEmpty(CATCH_INCLUDE_DIR): CATCH_INCLUDE_DIR=$$(CATCH_INCLUDE_DIR)
 !isEmpty(CATCH_INCLUDE_DIR): INCLUDEPATH *= $${CATCH_INCLUDE_DIR}
@@ -14,18 +14,27 @@ SOURCES += \
 	main.cpp     \
     quclibtest.cpp \
     ../source/crc.cpp \
+    ../source/checksum.cpp \
     ../source/hexFileParser.cpp \
-    ../source/cobs.cpp
+    ../source/memoryImage.cpp \
+    ../source/cobs.cpp \
+    ../source/CANbeSerial.cpp
 
 HEADERS += \
     ../source/cobs.h \
+    ../source/CANbeSerial.h \
     ../source/crc.h \
+    ../source/checksum.h \
     ../source/hexFileParser.h \
+    ../source/memoryImage.h \
     catch2/catch.hpp \
     catch2/catch_reporter_automake.hpp \
     catch2/catch_reporter_sonarqube.hpp \
     catch2/catch_reporter_tap.hpp \
     catch2/catch_reporter_teamcity.hpp \
     hexFileParser/test_hexFileParser.hpp \
+    test_checksum.hpp \
+    test_memoryImage.hpp \
     test_cobs.hpp \
+    test_CANbeSerial.hpp \
     test_crc.hpp
@@ -1,9 +1,53 @@
 #include <catch2/catch.hpp>
 #include "../source/hexFileParser.h"
+#include "../source/crc.h"
+#include <QDir>
+#include <QBuffer>
+#include <QFileInfo>
+#include <QDateTime>
 using namespace QuCLib;
 
 QString testFileFolder = "C:/Users/Christian/Raumsteuerung/QuCLib/test/hexFileParser/";
 
+// Same chunks with the same data at the same offsets
+static void requireSameBinary(const HexFileParser &parser, const HexFileParser &expected)
+{
+    QList<HexFileParser::BinaryChunk> binary = parser.binary();
+    QList<HexFileParser::BinaryChunk> expectedBinary = expected.binary();
+    REQUIRE(binary.count() == expectedBinary.count());
+    for(qsizetype i = 0; i < expectedBinary.count(); i++){
+        REQUIRE(binary.at(i).offset == expectedBinary.at(i).offset);
+        REQUIRE(binary.at(i).data == expectedBinary.at(i).data);
+    }
+}
+
+// Sequential device that stays open after its data was read, like a socket
+class OpenStream : public QIODevice
+{
+public:
+    OpenStream(const QByteArray &data) : _data(data) {}
+
+    bool isSequential() const override { return true; }
+    bool waitForReadyRead(int msecs) override { waitTimeout = msecs; waitCount++; return false; }
+
+    int waitCount = 0;
+    int waitTimeout = -1;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        qint64 count = std::min<qint64>(maxSize, _data.size() - _position);
+        memcpy(data, _data.constData() + _position, count);
+        _position += count;
+        return count;
+    }
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    QByteArray _data;
+    qint64 _position = 0;
+};
+
 TEST_CASE( "HEX File Parser", "[hexFileParser]" ) {
 
     SECTION("Valid file 1") {
@@ -38,6 +82,16 @@ TEST_CASE( "HEX File Parser", "[hexFileParser]" ) {
         REQUIRE(parser.errors().at(0).error == HexFileParser::ErrorType::InvalidChecksum);
     }
 
+    SECTION("Invalide data file") {
+        HexFileParser parser;
+        parser.load(testFileFolder+"test_file_invalid_data.hex");
+
+        REQUIRE(parser.errorCount() == 1);
+        REQUIRE(parser.errors().at(0).error == HexFileParser::ErrorType::InvalidDataByte);
+        REQUIRE(parser.errors().at(0).lineIndex == 4);
+        REQUIRE(parser.errors().at(0).column == 29);
+    }
+
     SECTION("Address range split and gap fill") {
         HexFileParser parser;
         parser.setAddressGapSize(16);
@@ -89,6 +143,39 @@ TEST_CASE( "HEX File Parser", "[hexFileParser]" ) {
         REQUIRE(parser.binary().at(1).offset == 0x00010060);
     }
 
+    SECTION("Sector alignment") {
+        HexFileParser parser;
+        parser.setAddressGapSize(16);
+        parser.setAddressAlignment(0x10000);
+
+        parser.load(testFileFolder+"test_file_with_gaps.hex");
+
+        REQUIRE(parser.errorCount() == 0);
+        REQUIRE(parser.binary().count() == 1);
+        REQUIRE(parser.binary().at(0).offset == 0x00010000);
+        REQUIRE(parser.binary().at(0).data.size() == 0x10000);
+        REQUIRE(parser.extract(0x00010030, 0x34) == QByteArray(0x34, '\xFF'));
+        REQUIRE(parser.extract(0x00010084, 0xFF7C) == QByteArray(0xFF7C, '\xFF'));
+    }
+
+    SECTION("Alignment wider than the gap") {
+        // Aligned to the same 256 byte block, further apart than the gap size
+        HexFileParser parser;
+        parser.setAddressGapSize(16);
+        parser.setAddressAlignment(256);
+
+        REQUIRE(parser.load(QByteArrayView(":041000001122334442\n:0410F000AABBCCDDEE\n:011200005598\n:00000001FF\n")));
+        REQUIRE(parser.errorCount() == 0);
+        REQUIRE(parser.binary().count() == 2);
+        REQUIRE(parser.binary().at(0).offset == 0x1000);
+        REQUIRE(parser.binary().at(0).data.size() == 0x100);
+        REQUIRE(parser.binary().at(1).offset == 0x1200);
+        REQUIRE(parser.extract(0x1000, 4) == QByteArray("\x11\x22\x33\x44", 4));
+        REQUIRE(parser.extract(0x1004, 0xEC) == QByteArray(0xEC, '\xFF'));
+        REQUIRE(parser.extract(0x10F0, 4) == QByteArray("\xAA\xBB\xCC\xDD", 4));
+        REQUIRE(parser.extract(0x1200, 1) == QByteArray("\x55", 1));
+    }
+
     SECTION("Data outside addess range (Too low)") {
         HexFileParser parser;
         parser.setMemorySize(0x00010001, 0xFFFF);
@@ -136,6 +223,183 @@ TEST_CASE( "HEX File Parser", "[hexFileParser]" ) {
         QByteArray pass1 = QByteArray("\x98\x0B\x01\x20\xB1\x05\x01\x00\xAD\x05\x01\x00\xAD\x05\x01\x00\xAD\x05", 18);
 
         REQUIRE(parser.extract(0x00010064,18) == pass1);
+
+        QByteArray pass2 = QByteArray("\x00\x00", 2) + QByteArray(0x34, '\xFF') + QByteArray("\x98\x0B", 2);
+        REQUIRE(parser.extract(0x0001002E,0x38) == pass2);
+    }
+
+    SECTION("Extract view") {
+        HexFileParser parser;
+        parser.setAddressGapSize(16);
+        parser.load(testFileFolder+"test_file_with_gaps.hex");
+
+        QByteArray buffer;
+        QByteArrayView view = parser.extractView(0x00010064, 18, buffer);
+        REQUIRE(view.toByteArray() == parser.extract(0x00010064, 18));
+        REQUIRE(buffer.isEmpty());
+
+        view = parser.extractView(0x0001002E, 0x38, buffer);
+        REQUIRE(view.data() == buffer.constData());
+        REQUIRE(view.toByteArray() == parser.extract(0x0001002E, 0x38));
+
+        uint64_t dataSize = 0;
+        uint64_t fillSize = 0;
+        parser.extract(0x0001002E, 0x38, [&](QByteArrayView data){ dataSize += data.size(); }, [&](uint64_t count){ fillSize += count; });
+        REQUIRE(dataSize == 4);
+        REQUIRE(fillSize == 0x34);
+    }
+
+    SECTION("Flash pages") {
+        HexFileParser parser;
+        parser.setAddressGapSize(16);
+        parser.load(testFileFolder+"test_file_with_gaps.hex");
+
+        QList<HexFileParser::FlashPage> pages;
+        QByteArrayList pageData;
+        REQUIRE(parser.forEachPage(HexFileParser::FlashGeometry::uniform(0x00010000, 0x40, 4, 16), [&](const HexFileParser::FlashPage &page){
+            pages.append(page);
+            pageData.append(page.data.toByteArray());
+            return true;
+        }));
+
+        REQUIRE(pages.count() == 6);
+        const uint32_t addresses[] = {0x00010000, 0x00010010, 0x00010020, 0x00010060, 0x00010070, 0x00010080};
+        const qsizetype sectors[] = {0, 0, 0, 1, 1, 2};
+        for(qsizetype i = 0; i < pages.count(); i++){
+            REQUIRE(pages.at(i).address == addresses[i]);
+            REQUIRE(pages.at(i).sector == sectors[i]);
+            REQUIRE(pages.at(i).blank == (i == 1));
+        }
+        REQUIRE(pageData.at(3) == QByteArray("\xFF\xFF\xFF\xFF\x98\x0B\x01\x20\xB1\x05\x01\x00\xAD\x05\x01\x00", 16));
+        REQUIRE(pageData.at(5) == QByteArray("\x00\x00\x00\x00", 4) + QByteArray(12, '\xFF'));
+
+        HexFileParser large;
+        QByteArray data(0x200, '\xFF');
+        data[0x1C0] = 0x00;
+        large.insert(HexFileParser::BinaryChunk{0x08000000, data});
+        QList<bool> blank;
+        REQUIRE(!large.forEachPage(HexFileParser::FlashGeometry::uniform(0x08000000, 0x1000, 2), [&](const HexFileParser::FlashPage &page){
+            blank.append(page.blank);
+            return blank.count() < 2;
+        }));
+        REQUIRE(blank == QList<bool>{true, false});
+    }
+
+    SECTION("Flash diff") {
+        HexFileParser parser;
+        parser.setAddressGapSize(16);
+        parser.load(testFileFolder+"test_file_with_gaps.hex");
+        HexFileParser::FlashGeometry geometry = HexFileParser::FlashGeometry::uniform(0x00010000, 0x40, 4, 16);
+
+        HexFileParser device = parser;
+        HexFileParser::FlashUpdate update = parser.diff(device, geometry);
+        REQUIRE(update.changedPages == 0);
+        REQUIRE(update.sectors.isEmpty());
+        REQUIRE(update.pages.isEmpty());
+
+        device.replace(0x00010070, QByteArray("\x12", 1));
+        update = parser.diff(device, geometry);
+        REQUIRE(update.changedPages == 1);
+        REQUIRE(update.sectors == QList<qsizetype>{1});
+        REQUIRE(update.pages.count() == 2);
+        REQUIRE(update.pages.at(0).offset == 0x00010060);
+        REQUIRE(update.pages.at(0).data == parser.extract(0x00010060, 16));
+        REQUIRE(update.pages.at(1).offset == 0x00010070);
+        REQUIRE(update.pages.at(1).data == parser.extract(0x00010070, 16));
+
+        QByteArray readback = parser.extract(0x00010000, 0x100);
+        REQUIRE(parser.diff(0x00010000, readback, geometry).changedPages == 0);
+
+        readback[0] = 0x00;
+        update = parser.diff(0x00010000, readback, geometry);
+        REQUIRE(update.changedPages == 1);
+        REQUIRE(update.sectors == QList<qsizetype>{0});
+        REQUIRE(update.pages.count() == 2); // the blank page 0x00010010 is not programmed
+        REQUIRE(update.pages.at(0).offset == 0x00010000);
+        REQUIRE(update.pages.at(1).offset == 0x00010020);
+    }
+
+    SECTION("Flash diff with device data outside the image") {
+        HexFileParser parser;
+        parser.insert(HexFileParser::BinaryChunk{0x0000, QByteArray(256, '\x11')});
+        HexFileParser device = parser;
+        device.insert(HexFileParser::BinaryChunk{0x0100, QByteArray(1, '\x22')});
+        device.insert(HexFileParser::BinaryChunk{0x1000, QByteArray(1, '\x33')});
+        HexFileParser::FlashGeometry geometry = HexFileParser::FlashGeometry::uniform(0, 0x1000, 2, 256);
+
+        // Both sectors hold data the image doesn't, they are erased and only the image's page is programmed again
+        HexFileParser::FlashUpdate update = parser.diff(device, geometry);
+        REQUIRE(update.changedPages == 2);
+        REQUIRE(update.sectors == QList<qsizetype>{0, 1});
+        REQUIRE(update.pages.count() == 1);
+        REQUIRE(update.pages.at(0).offset == 0x0000);
+        REQUIRE(update.pages.at(0).data == QByteArray(256, '\x11'));
+
+        update = parser.diff(0, device.extract(0, 0x2000), geometry);
+        REQUIRE(update.changedPages == 2);
+        REQUIRE(update.sectors == QList<qsizetype>{0, 1});
+    }
+
+    SECTION("Hash manifest") {
+        HexFileParser parser;
+        parser.setAddressGapSize(16);
+        parser.load(testFileFolder+"test_file_with_gaps.hex");
+        HexFileParser::FlashGeometry geometry = HexFileParser::FlashGeometry::uniform(0x00010000, 0x40, 4, 16);
+
+        QList<uint32_t> manifest = parser.hashManifest(geometry);
+        REQUIRE(manifest.count() == 4);
+        REQUIRE(manifest.at(0) == Crc::crc32(parser.extract(0x00010000, 0x40)));
+        REQUIRE(manifest.at(3) == Crc::crc32_addFill(Crc::crc32_initValue, 0xFF, 0x40));
+        REQUIRE(parser.hashManifest(geometry, HexFileParser::FlashHash::Crc32c).at(1) == Crc::crc32c(parser.extract(0x00010040, 0x40)));
+        REQUIRE(parser.hashManifest(geometry, HexFileParser::FlashHash::Crc32Stm32).at(2) == parser.crc32Stm32(0x00010080, 0x40));
+
+        QList<uint32_t> pages = parser.hashManifest(geometry, HexFileParser::FlashHash::Crc32, true);
+        REQUIRE(pages.count() == 16);
+        parser.setThreadCount(3);
+        REQUIRE(parser.hashManifest(geometry, HexFileParser::FlashHash::Crc32, true) == pages);
+        REQUIRE(pages.at(6) == Crc::crc32(parser.extract(0x00010060, 16)));
+
+        QList<uint32_t> device = manifest;
+        device[1] ^= 1;
+        device.removeLast();
+        REQUIRE(HexFileParser::compareManifest(manifest, device) == QList<qsizetype>{1, 3});
+        REQUIRE(HexFileParser::compareManifest(manifest, manifest).isEmpty());
+    }
+
+    SECTION("Hash manifest matches diff") {
+        HexFileParser parser;
+        parser.insert(HexFileParser::BinaryChunk{0x0000, QByteArray(256, '\x11')});
+        parser.insert(HexFileParser::BinaryChunk{0x2010, QByteArray(16, '\x44')});
+        HexFileParser device = parser;
+        device.insert(HexFileParser::BinaryChunk{0x0100, QByteArray(1, '\x22')});
+        device.insert(HexFileParser::BinaryChunk{0x1000, QByteArray(1, '\x33')});
+        HexFileParser::FlashGeometry geometry = HexFileParser::FlashGeometry::uniform(0, 0x1000, 4, 256);
+
+        QList<qsizetype> changed = HexFileParser::compareManifest(parser.hashManifest(geometry), device.hashManifest(geometry));
+        REQUIRE(changed == QList<qsizetype>{0, 1});
+        REQUIRE(parser.diff(device, geometry).sectors == changed);
+
+        device.replace(0x2010, QByteArray(1, '\x45'));
+        changed = HexFileParser::compareManifest(parser.hashManifest(geometry), device.hashManifest(geometry));
+        REQUIRE(changed == QList<qsizetype>{0, 1, 2});
+        REQUIRE(parser.diff(device, geometry).sectors == changed);
+    }
+
+    SECTION("Insert data") {
+        HexFileParser parser;
+        parser.setAddressGapSize(16);
+        parser.setCrcCacheEnabled(true);
+
+        parser.load(testFileFolder+"test_file_with_gaps.hex");
+
+        REQUIRE(parser.binary().count() == 2);
+
+        parser.insert(HexFileParser::BinaryChunk{0x00010030, QByteArray(0x34, '\x55')});
+
+        REQUIRE(parser.binary().count() == 1);
+        REQUIRE(parser.binary().at(0).data.size() == 0x84);
+        REQUIRE(parser.binaryAddressRange().maximum == 0x00010083);
+        REQUIRE(parser.imageCrc32() == parser.crc32(0x00010000, 0x84));
     }
 
     SECTION("Replace data") {
@@ -162,4 +426,416 @@ TEST_CASE( "HEX File Parser", "[hexFileParser]" ) {
         REQUIRE(parser.binary().at(0).data == pass0);
         REQUIRE(parser.binary().at(1).data == pass1);
     }
+
+    SECTION("CRC over address range") {
+        HexFileParser parser;
+        parser.setAddressGapSize(16);
+
+        parser.load(testFileFolder+"test_file_with_gaps.hex");
+
+        REQUIRE(parser.errorCount() == 0);
+
+        QByteArray image(0x100, '\xFF');
+        for(const HexFileParser::BinaryChunk &chunk: parser.binary()){
+            image.replace(chunk.offset - 0x0000FFF0, chunk.data.size(), chunk.data);
+        }
+
+        REQUIRE(parser.crc32(0x0000FFF0, 0x100) == Crc::crc32(image));
+        REQUIRE(parser.crc32(0x00010008, 0x70) == Crc::crc32(image.mid(0x18, 0x70)));
+
+        REQUIRE(parser.crc32Stm32(0x0000FFF0, 0x100) == Crc::crc32Stm32(image));
+        REQUIRE(parser.crc32Stm32(0x0001000A, 0x63) == Crc::crc32Stm32(image.mid(0x1A, 0x63)));
+    }
+
+    SECTION("Cached CRC after replace") {
+        HexFileParser parser;
+        parser.setAddressGapSize(16);
+        parser.setCrcCacheEnabled(true);
+
+        parser.load(testFileFolder+"test_file_with_gaps.hex");
+
+        REQUIRE(parser.errorCount() == 0);
+
+        parser.replace(0x00010074, QByteArray("\xAB\xCD\xEF\xAA", 4));
+        parser.replace(0x00010002, QByteArray("\x12\x34", 2));
+
+        uint32_t range = parser.binaryAddressRange().maximum - parser.binaryAddressRange().minimum + 1;
+        REQUIRE(parser.imageCrc32() == parser.crc32(parser.binaryAddressRange().minimum, range));
+
+        // Empty writes outside of the loaded ranges leave the cache unchanged
+        parser.replace(0x00001800, QByteArray());
+        parser.insert(HexFileParser::BinaryChunk{0x00020000, QByteArray()});
+        REQUIRE(parser.binary().count() == 2);
+        REQUIRE(parser.imageCrc32() == parser.crc32(parser.binaryAddressRange().minimum, range));
+
+        parser.setCrcCacheEnabled(false);
+        REQUIRE(parser.imageCrc32() == parser.crc32(parser.binaryAddressRange().minimum, range));
+    }
+
+    SECTION("Page table storage") {
+        HexFileParser chunks;
+        chunks.setAddressGapSize(16);
+        chunks.setAddressAlignment(16);
+        chunks.load(testFileFolder+"test_file_with_gaps.hex");
+
+        HexFileParser pages;
+        pages.setAddressGapSize(16);
+        pages.setAddressAlignment(16);
+        pages.setImageStorage(MemoryImage::Storage::Pages);
+        pages.setCrcCacheEnabled(true);
+        pages.load(testFileFolder+"test_file_with_gaps.hex");
+
+        requireSameBinary(pages, chunks);
+
+        pages.replace(0x00010074, QByteArray("\xAB\xCD\xEF\xAA", 4));
+        chunks.replace(0x00010074, QByteArray("\xAB\xCD\xEF\xAA", 4));
+        REQUIRE(pages.extract(0x00010000, 0x90) == chunks.extract(0x00010000, 0x90));
+        REQUIRE(pages.imageCrc32() == chunks.imageCrc32());
+
+        chunks.setImageStorage(MemoryImage::Storage::Pages);
+        REQUIRE(chunks.extract(0x00010000, 0x90) == pages.extract(0x00010000, 0x90));
+    }
+
+    SECTION("Save file") {
+        HexFileParser parser;
+        parser.load(testFileFolder+"test_file_1.hex");
+        REQUIRE(parser.errorCount() == 0);
+
+        QByteArray data;
+        for(int i = 0; i < 0x300; i++) data.append((char)(i*13));
+        parser.insert(HexFileParser::BinaryChunk{0x0800FF00, data}); // crosses a 64 KiB border above 1 MiB
+
+        const uint8_t recordLengths[] = {16, 32, 64, 255};
+        for(uint8_t recordLength: recordLengths){
+            parser.setRecordLength(recordLength);
+            REQUIRE(parser.saveToFile(QDir::tempPath()+"/quclib_test_save.hex"));
+
+            HexFileParser loaded;
+            loaded.setAddressGapSize(0);
+            loaded.load(QDir::tempPath()+"/quclib_test_save.hex");
+
+            REQUIRE(loaded.errorCount() == 0);
+            requireSameBinary(loaded, parser);
+        }
+
+        QFile file(QDir::tempPath()+"/quclib_test_save.hex");
+        REQUIRE(file.open(QIODevice::ReadOnly));
+        QByteArray content = file.readAll();
+        file.close();
+        QFile::remove(QDir::tempPath()+"/quclib_test_save.hex");
+
+        REQUIRE(content.startsWith(":020000040001F9\n"));
+        REQUIRE(content.contains(":020000040800F2\n"));
+        REQUIRE(content.contains(":020000040801F1\n"));
+        REQUIRE(content.endsWith(":00000001FF\n"));
+    }
+
+    SECTION("S-record file") {
+        HexFileParser hex;
+        hex.setAddressGapSize(16);
+        hex.load(testFileFolder+"test_file_with_gaps.hex");
+
+        HexFileParser srec;
+        srec.setAddressGapSize(16);
+        REQUIRE(srec.loadSRecord(testFileFolder+"test_file_with_gaps.s28"));
+
+        REQUIRE(srec.errorCount() == 0);
+        REQUIRE(srec.fileAddressRange().minimum == hex.fileAddressRange().minimum);
+        REQUIRE(srec.fileAddressRange().maximum == hex.fileAddressRange().maximum);
+        requireSameBinary(srec, hex);
+
+        REQUIRE(!srec.load(testFileFolder+"test_file_with_gaps.s28"));
+        REQUIRE(srec.errors().at(0).error == HexFileParser::ErrorType::InvalidStartCode);
+    }
+
+    SECTION("Save S-record file") {
+        HexFileParser parser;
+        parser.load(testFileFolder+"test_file_2.hex");
+        parser.insert(HexFileParser::BinaryChunk{0x90000000, QByteArray(0x200, '\x5A')});
+
+        REQUIRE(parser.saveToSRecordFile(QDir::tempPath()+"/quclib_test_save.s37"));
+
+        HexFileParser loaded;
+        loaded.setAddressGapSize(0);
+        REQUIRE(loaded.loadSRecord(QDir::tempPath()+"/quclib_test_save.s37"));
+        QFile::remove(QDir::tempPath()+"/quclib_test_save.s37");
+
+        requireSameBinary(loaded, parser);
+    }
+
+    SECTION("ELF file") {
+        HexFileParser hex;
+        hex.setAddressGapSize(16);
+        hex.setAddressAlignment(16);
+        hex.load(testFileFolder+"test_file_with_gaps.hex");
+
+        const char *files[] = {"test_file_with_gaps.elf", "test_file_with_gaps_64be.elf"};
+        for(const char *file: files){
+            HexFileParser elf;
+            elf.setAddressGapSize(16);
+            elf.setAddressAlignment(16);
+            REQUIRE(elf.loadElf(testFileFolder+file));
+
+            REQUIRE(elf.errorCount() == 0);
+            REQUIRE(elf.fileAddressRange().minimum == hex.fileAddressRange().minimum);
+            REQUIRE(elf.fileAddressRange().maximum == hex.fileAddressRange().maximum);
+            requireSameBinary(elf, hex);
+        }
+
+        HexFileParser limited;
+        limited.setMemorySize(0x00010000, 0x60);
+        REQUIRE(limited.loadElf(testFileFolder+"test_file_with_gaps.elf"));
+        REQUIRE(limited.warningCount() == 1);
+        REQUIRE(limited.warnings().at(0).lineIndex == 2);
+        REQUIRE(limited.warnings().at(0).error == HexFileParser::ErrorType::AddressRangeTooHigh);
+
+        HexFileParser invalid;
+        REQUIRE(!invalid.loadElf(testFileFolder+"test_file_1.hex"));
+        REQUIRE(invalid.errors().at(0).error == HexFileParser::ErrorType::InvalidFileHeader);
+    }
+
+    SECTION("Auto detect") {
+        HexFileParser hex;
+        hex.setAddressGapSize(16);
+        hex.setAddressAlignment(16);
+        hex.load(testFileFolder+"test_file_with_gaps.hex");
+
+        const char *files[][2] = {{"test_file_with_gaps.hex", "Intel HEX"}, {"test_file_with_gaps.s28", "S-record"}, {"test_file_with_gaps.elf", "ELF"}, {"test_file_with_gaps.txt", "TI-TXT"}};
+        for(const auto &file: files){
+            HexFileParser parser;
+            parser.setAddressGapSize(16);
+            parser.setAddressAlignment(16);
+            REQUIRE(parser.loadAutoDetect(testFileFolder+file[0]));
+
+            REQUIRE(parser.fileFormat() == file[1]);
+            REQUIRE(parser.errorCount() == 0);
+            requireSameBinary(parser, hex);
+        }
+
+        QFile file(QDir::tempPath()+"/quclib_test_detect.bin");
+        file.open(QIODevice::WriteOnly);
+        file.write(QByteArray("QUCTEST\x01\x01\x02\x03", 11));
+        file.close();
+
+        HexFileParser binary;
+        binary.setMemorySize(0x08000000, 0x1000);
+        REQUIRE(binary.loadAutoDetect(file.fileName()));
+        REQUIRE(binary.fileFormat() == "Binary");
+        REQUIRE(binary.binary().at(0).offset == 0x08000000);
+        REQUIRE(binary.binary().at(0).data == QByteArray("QUCTEST\x01\x01\x02\x03", 11));
+
+        // The reader is process wide, its magic matches no other test file
+        HexFileParser::registerReader(HexFileParser::FileReader{"Test",
+            [](QByteArrayView head){ return head.startsWith(QByteArrayView("QUCTEST\x01", 8)); },
+            [](const HexFileParser &, QByteArrayView data, HexFileParser::ReaderOutput &output){
+                output.binary.append(HexFileParser::BinaryChunk{0x2000, data.sliced(8).toByteArray()});
+                output.fileAddress = HexFileParser::Range{0x2000, (uint32_t)(0x2000 + data.size() - 9)};
+            }});
+
+        HexFileParser custom;
+        REQUIRE(custom.loadAutoDetect(file.fileName()));
+        REQUIRE(custom.fileFormat() == "Test");
+        REQUIRE(custom.binary().at(0).offset == 0x2000);
+        REQUIRE(custom.binary().at(0).data == QByteArray("\x01\x02\x03", 3));
+
+        REQUIRE(HexFileParser::unregisterReader("Test"));
+        REQUIRE_FALSE(HexFileParser::unregisterReader("Test"));
+        REQUIRE(HexFileParser::readers().count() == 5);
+
+        HexFileParser removed;
+        removed.setMemorySize(0x08000000, 0x1000);
+        REQUIRE(removed.loadAutoDetect(file.fileName()));
+        QFile::remove(file.fileName());
+        REQUIRE(removed.fileFormat() == "Binary");
+    }
+
+    SECTION("Load from memory and device") {
+        const char *files[] = {"test_file_1.hex", "test_file_with_gaps.hex", "test_file_invalid_checksum.hex"};
+        for(const char *file: files){
+            HexFileParser parser;
+            parser.load(testFileFolder+file);
+
+            QFile hexFile(testFileFolder+file);
+            hexFile.open(QIODevice::ReadOnly);
+            QByteArray content = hexFile.readAll();
+            hexFile.close();
+
+            HexFileParser memory;
+            REQUIRE(memory.load(QByteArrayView(content)) == (parser.errorCount() == 0));
+
+            QBuffer buffer(&content);
+            buffer.open(QIODevice::ReadOnly);
+            HexFileParser device;
+            REQUIRE(device.load(buffer) == (parser.errorCount() == 0));
+
+            for(const HexFileParser *loaded: {&memory, &device}){
+                REQUIRE(loaded->errorCount() == parser.errorCount());
+                for(uint32_t i = 0; i < parser.errorCount(); i++){
+                    REQUIRE(loaded->errors().at(i).lineIndex == parser.errors().at(i).lineIndex);
+                    REQUIRE(loaded->errors().at(i).error == parser.errors().at(i).error);
+                }
+                requireSameBinary(*loaded, parser);
+            }
+        }
+
+        QBuffer closed;
+        HexFileParser parser;
+        REQUIRE(!parser.load(closed));
+        REQUIRE(parser.errors().at(0).error == HexFileParser::ErrorType::FileNotOpen);
+    }
+
+    SECTION("Load from an open stream") {
+        // Reading stops at the end of file record, with or without a line end after it
+        for(const char *content: {":041000001122334442\n:00000001FF\n", ":041000001122334442\r\n:00000001FF"}){
+            OpenStream stream(content);
+            stream.open(QIODevice::ReadOnly);
+            HexFileParser parser;
+            REQUIRE(parser.load(stream));
+            REQUIRE(stream.waitCount == 0);
+            REQUIRE(parser.extract(0x1000, 4) == QByteArray("\x11\x22\x33\x44", 4));
+        }
+
+        // Without it the parser waits for more data until the timeout
+        OpenStream stream(":041000001122334442\n");
+        stream.open(QIODevice::ReadOnly);
+        HexFileParser parser;
+        parser.setStreamTimeout(100);
+        REQUIRE(parser.load(stream));
+        REQUIRE(stream.waitCount == 1);
+        REQUIRE(stream.waitTimeout == 100);
+        REQUIRE(parser.extract(0x1000, 4) == QByteArray("\x11\x22\x33\x44", 4));
+    }
+
+    SECTION("Load cache") {
+        QFile fixture(testFileFolder+"test_file_with_gaps.hex");
+        fixture.open(QIODevice::ReadOnly);
+        QByteArray content = fixture.readAll();
+        fixture.close();
+
+        QString filePath = QDir::tempPath()+"/quclib_test_cache.hex";
+        QString cachePath = HexFileParser::cacheFilePath(filePath);
+        QFile file(filePath);
+        file.open(QIODevice::WriteOnly);
+        file.write(content);
+        file.close();
+        QFile::remove(cachePath);
+
+        HexFileParser parser;
+        parser.setLoadCacheEnabled(true);
+        parser.setMemorySize(0x00010000, 0x82);
+        REQUIRE(parser.load(filePath));
+        REQUIRE(QFile::exists(cachePath));
+
+        HexFileParser cached;
+        cached.setLoadCacheEnabled(true);
+        cached.setMemorySize(0x00010000, 0x82);
+        REQUIRE(cached.load(filePath));
+        REQUIRE(cached.fileFormat() == "Intel HEX");
+        REQUIRE(cached.warningCount() == 1);
+        REQUIRE(cached.warnings().at(0).error == HexFileParser::ErrorType::AddressRangeTooHigh);
+        REQUIRE(cached.fileAddressRange().minimum == parser.fileAddressRange().minimum);
+        REQUIRE(cached.fileAddressRange().maximum == parser.fileAddressRange().maximum);
+        requireSameBinary(cached, parser);
+
+        // The data comes from the cache while the file is unchanged
+        QFile cacheFile(cachePath);
+        cacheFile.open(QIODevice::ReadOnly);
+        QByteArray cache = cacheFile.readAll();
+        cacheFile.close();
+        cache.replace(QByteArray("\xDD\xCC\xBB\xAA", 4), QByteArray("\x11\x22\x33\x44", 4));
+        cacheFile.open(QIODevice::WriteOnly);
+        cacheFile.write(cache);
+        cacheFile.close();
+
+        REQUIRE(cached.load(filePath));
+        REQUIRE(cached.extract(0x00010000, 4) == QByteArray("\x11\x22\x33\x44", 4));
+
+        // A touched file is compared by its hash once, the cache then takes the new time
+        file.open(QIODevice::ReadWrite);
+        QDateTime touched = QFileInfo(filePath).lastModified().addSecs(-3600);
+        REQUIRE(file.setFileTime(touched, QFileDevice::FileModificationTime));
+        file.close();
+        REQUIRE(cached.load(filePath));
+        REQUIRE(cached.extract(0x00010000, 4) == QByteArray("\x11\x22\x33\x44", 4));
+
+        // Same size and time: the cache is used without reading the file
+        file.open(QIODevice::WriteOnly);
+        file.write(QByteArray(content).replace(":10000000DDCCBBAA", ":1000000011CCBBAA"));
+        file.flush();
+        REQUIRE(file.setFileTime(touched, QFileDevice::FileModificationTime));
+        file.close();
+        REQUIRE(cached.load(filePath));
+        REQUIRE(cached.extract(0x00010000, 4) == QByteArray("\x11\x22\x33\x44", 4));
+
+        file.open(QIODevice::WriteOnly);
+        file.write(content);
+        file.close();
+
+        // Other settings or a changed file invalidate the cache
+        cached.setMemorySize(0x00000000, 0x00100000);
+        REQUIRE(cached.load(filePath));
+        REQUIRE(cached.extract(0x00010000, 4) == QByteArray("\xDD\xCC\xBB\xAA", 4));
+        REQUIRE(cached.warningCount() == 0);
+
+        file.open(QIODevice::WriteOnly);
+        file.write(content.replace(":10000000DDCCBBAA", ":1000000011CCBBAA") + "\n");
+        file.close();
+        REQUIRE(!cached.load(filePath));
+        REQUIRE(cached.errors().at(0).error == HexFileParser::ErrorType::InvalidChecksum);
+
+        QFile::remove(filePath);
+        QFile::remove(cachePath);
+    }
+
+    SECTION("Asynchronous load") {
+        HexFileParser parser;
+        parser.setAddressGapSize(16);
+        parser.load(testFileFolder+"test_file_with_gaps.hex");
+
+        HexFileParser settings;
+        settings.setAddressGapSize(16);
+        QList<HexFileParser::LoadTask> tasks;
+        tasks.append(settings.loadAsync(testFileFolder+"test_file_with_gaps.hex"));
+        tasks.append(settings.loadAsync(testFileFolder+"test_file_with_gaps.s28", &HexFileParser::loadSRecord));
+        for(const HexFileParser::LoadTask &task: tasks){
+            const HexFileParser &loaded = task.result();
+            REQUIRE(task.isFinished());
+            REQUIRE(loaded.errorCount() == 0);
+            REQUIRE(task.bytesTotal() > 0);
+            REQUIRE(task.bytesProcessed() == task.bytesTotal());
+            requireSameBinary(loaded, parser);
+        }
+
+        HexFileParser large;
+        large.insert(HexFileParser::BinaryChunk{0x08000000, QByteArray(8*1024*1024, '\x5A')});
+        REQUIRE(large.saveToFile(QDir::tempPath()+"/quclib_test_async.hex"));
+
+        HexFileParser::LoadTask task = settings.loadAsync(QDir::tempPath()+"/quclib_test_async.hex");
+        task.cancel();
+        REQUIRE(task.result().errorCount() == 1);
+        REQUIRE(task.result().errors().at(0).error == HexFileParser::ErrorType::Canceled);
+        REQUIRE(task.bytesProcessed() < task.bytesTotal());
+        QFile::remove(QDir::tempPath()+"/quclib_test_async.hex");
+    }
+
+    SECTION("Multi-threaded load") {
+        const char *files[] = {"test_file_1.hex", "test_file_2.hex", "test_file_with_gaps.hex", "test_file_invalid_checksum.hex", "test_file_invalid_data.hex"};
+        for(const char *file: files){
+            HexFileParser single;
+            single.load(testFileFolder+file);
+
+            HexFileParser parallel;
+            parallel.setThreadCount(7);
+            parallel.load(testFileFolder+file);
+
+            REQUIRE(parallel.errorCount() == single.errorCount());
+            for(uint32_t i = 0; i < single.errorCount(); i++){
+                REQUIRE(parallel.errors().at(i).lineIndex == single.errors().at(i).lineIndex);
+                REQUIRE(parallel.errors().at(i).error == single.errors().at(i).error);
+            }
+            REQUIRE(parallel.fileAddressRange().minimum == single.fileAddressRange().minimum);
+            REQUIRE(parallel.fileAddressRange().maximum == single.fileAddressRange().maximum);
+            requireSameBinary(parallel, single);
+        }
+    }
 }
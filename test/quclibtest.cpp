@@ -2,5 +2,8 @@
 
 
 #include "test_cobs.hpp"
+#include "test_CANbeSerial.hpp"
 #include "test_crc.hpp"
+#include "test_checksum.hpp"
+#include "test_memoryImage.hpp"
 #include "hexFileParser/test_hexFileParser.hpp"
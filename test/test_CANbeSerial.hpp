@@ -0,0 +1,147 @@
+#include <catch2/catch.hpp>
+#include "../source/CANbeSerial.h"
+
+// Reference values from a bit level model of the frame on the bus (ISO 11898-1:2015)
+
+static CanBusFrame canFrame(uint32_t identifier, bool extended, bool fd, bool bitRateSwitch, QByteArray data)
+{
+    CanBusFrame frame;
+    frame.isValide = true;
+    frame.timestamp = 0;
+    frame.identifier = identifier;
+    frame.extended = extended;
+    frame.fd = fd;
+    frame.rtr = false;
+    frame.bitRateSwitch = bitRateSwitch;
+    frame.data = data;
+    return frame;
+}
+
+TEST_CASE( "CANbeSerial frame timing", "[CANbeSerial]" ) {
+
+    SECTION( "Classic frame, all dominant" ) {
+        CanBusFrame frame = canFrame(0x000, false, false, false, QByteArray());
+
+        // 34 dominant bits from SOF to the end of the CRC, a stuff bit after every fifth
+        CanFrameTiming timing = CANbeSerial::frameTiming(frame, CANbeSerial::Baud125k, CANbeSerial::Baud125k);
+        REQUIRE(CANbeSerial::frameCrc(frame) == 0x0000);
+        REQUIRE(timing.bitCount == 53);
+        REQUIRE(timing.stuffBitCount == 6);
+        REQUIRE(timing.dataBitCount == 0);
+        REQUIRE(timing.duration == 424000);
+    }
+
+    SECTION( "Classic frame" ) {
+        CanBusFrame frame = canFrame(0x123, false, false, false, QByteArray("\x11\x22\x33\x44\x55\x66\x77\x88", 8));
+
+        CanFrameTiming timing = CANbeSerial::frameTiming(frame, CANbeSerial::Baud500k, CANbeSerial::Baud500k);
+        REQUIRE(CANbeSerial::frameCrc(frame) == 0x4237);
+        REQUIRE(timing.bitCount == 112);
+        REQUIRE(timing.stuffBitCount == 1);
+        REQUIRE(timing.dataBitCount == 0);
+        REQUIRE(timing.duration == 224000);
+    }
+
+    SECTION( "Classic remote frame" ) {
+        CanBusFrame frame = canFrame(0x7FF, false, false, false, QByteArray(2, '\x00'));
+        frame.rtr = true;
+
+        // DLC of two, but no data field
+        CanFrameTiming timing = CANbeSerial::frameTiming(frame, CANbeSerial::Baud125k, CANbeSerial::Baud125k);
+        REQUIRE(CANbeSerial::frameCrc(frame) == 0x1A41);
+        REQUIRE(timing.bitCount == 50);
+        REQUIRE(timing.stuffBitCount == 3);
+    }
+
+    SECTION( "Classic frame, extended identifier" ) {
+        CanBusFrame frame = canFrame(0x12345678, true, false, false, QByteArray("\x01\x02\x03", 3));
+
+        CanFrameTiming timing = CANbeSerial::frameTiming(frame, CANbeSerial::Baud125k, CANbeSerial::Baud125k);
+        REQUIRE(CANbeSerial::frameCrc(frame) == 0x5B84);
+        REQUIRE(timing.bitCount == 95);
+        REQUIRE(timing.stuffBitCount == 4);
+        REQUIRE(timing.dataBitCount == 0);
+    }
+
+    SECTION( "FD frame without data" ) {
+        CanBusFrame frame = canFrame(0x000, false, true, false, QByteArray());
+
+        CanFrameTiming timing = CANbeSerial::frameTiming(frame, CANbeSerial::Baud500k, CANbeSerial::Baud2M);
+        REQUIRE(CANbeSerial::frameCrc(frame) == 0x072BF);
+        REQUIRE(timing.bitCount == 65);
+        REQUIRE(timing.stuffBitCount == 3 + 6);
+        REQUIRE(timing.dataBitCount == 0);
+    }
+
+    SECTION( "FD frame, CRC-17" ) {
+        QByteArray data;
+        for(uint8_t i = 0; i < 12; i++) data.append(i);
+        CanBusFrame frame = canFrame(0x123, false, true, false, data);
+
+        // Without bit rate switch the whole frame uses the nominal baudrate
+        CanFrameTiming timing = CANbeSerial::frameTiming(frame, CANbeSerial::Baud500k, CANbeSerial::Baud2M);
+        REQUIRE(CANbeSerial::frameCrc(frame) == 0x17058);
+        REQUIRE(timing.bitCount == 169);
+        REQUIRE(timing.stuffBitCount == 11 + 6);
+        REQUIRE(timing.dataBitCount == 0);
+        REQUIRE(timing.duration == 338000);
+    }
+
+    SECTION( "FD frame, padded to the DLC size" ) {
+        QByteArray data;
+        for(uint8_t i = 0; i < 9; i++) data.append(i);
+        CanBusFrame frame = canFrame(0x123, false, true, false, data);
+        CanBusFrame padded = canFrame(0x123, false, true, false, data + QByteArray(3, '\xCC'));
+
+        CanFrameTiming timing = CANbeSerial::frameTiming(frame, CANbeSerial::Baud500k, CANbeSerial::Baud2M, '\xCC');
+        REQUIRE(CANbeSerial::frameCrc(frame, '\xCC') == 0x13A9E);
+        REQUIRE(CANbeSerial::frameCrc(padded) == 0x13A9E);
+        REQUIRE(timing.bitCount == 167);
+        REQUIRE(timing.stuffBitCount == 9 + 6);
+        REQUIRE(timing.bitCount == CANbeSerial::frameTiming(padded, CANbeSerial::Baud500k, CANbeSerial::Baud2M).bitCount);
+    }
+
+    SECTION( "FD frame with bit rate switch, CRC-21" ) {
+        CanBusFrame frame = canFrame(0x0AA, false, true, true, QByteArray(20, '\xFF'));
+
+        CanFrameTiming timing = CANbeSerial::frameTiming(frame, CANbeSerial::Baud500k, CANbeSerial::Baud2M);
+        REQUIRE(CANbeSerial::frameCrc(frame) == 0x0B3E41);
+        REQUIRE(timing.bitCount == 259);
+        REQUIRE(timing.stuffBitCount == 32 + 7);
+        REQUIRE(timing.dataBitCount == 229);
+        REQUIRE(timing.duration == 30 * 2000 + 229 * 500);
+    }
+
+    SECTION( "FD frame with bit rate switch, extended identifier" ) {
+        QByteArray data;
+        for(uint8_t i = 0; i < 64; i++) data.append(i * 3);
+        CanBusFrame frame = canFrame(0x01ABCDEF, true, true, true, data);
+
+        CanFrameTiming timing = CANbeSerial::frameTiming(frame, CANbeSerial::Baud500k, CANbeSerial::Baud2M);
+        REQUIRE(CANbeSerial::frameCrc(frame) == 0x18BD75);
+        REQUIRE(timing.bitCount == 612);
+        REQUIRE(timing.stuffBitCount == 14 + 7);
+        REQUIRE(timing.dataBitCount == 561);
+        REQUIRE(timing.duration == 51 * 2000 + 561 * 500);
+    }
+
+    SECTION( "Payload too long" ) {
+        // 256 bytes must not wrap around to a DLC of 0
+        for(qsizetype size: {65, 256}){
+            CanBusFrame frame = canFrame(0x123, false, true, true, QByteArray(size, '\x00'));
+
+            CanFrameTiming timing = CANbeSerial::frameTiming(frame, CANbeSerial::Baud500k, CANbeSerial::Baud2M);
+            REQUIRE(CANbeSerial::frameCrc(frame) == 0);
+            REQUIRE(timing.bitCount == 0);
+            REQUIRE(timing.stuffBitCount == 0);
+            REQUIRE(timing.duration == 0);
+        }
+    }
+
+    SECTION( "Baudrate" ) {
+        REQUIRE(CANbeSerial::baudrateToBitsPerSecond(CANbeSerial::Baud10k) == 10000);
+        REQUIRE(CANbeSerial::baudrateToBitsPerSecond(CANbeSerial::Baud125k) == 125000);
+        REQUIRE(CANbeSerial::baudrateToBitsPerSecond(CANbeSerial::Baud1M) == 1000000);
+        REQUIRE(CANbeSerial::baudrateToBitsPerSecond(CANbeSerial::Baud10M) == 10000000);
+    }
+}
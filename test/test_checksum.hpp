@@ -0,0 +1,54 @@
+#include <catch2/catch.hpp>
+#include "../source/checksum.h"
+
+using namespace QuCLib;
+
+TEST_CASE( "Test checksum", "[checksum]" ) {
+
+    QByteArray large;
+    for(int i = 0; i < 100000; i++) large.append((char)(i*7 + (i>>8)));
+
+    SECTION("Sum") {
+        QByteArray input = QByteArray("\x01\x02\xFF\x80", 4);
+        REQUIRE(Checksum::sum8(input) == 0x82);
+        REQUIRE(Checksum::sum16(input) == 0x0182);
+        REQUIRE(Checksum::sum32(input) == 0x00000182);
+
+        uint32_t sum = 0;
+        for(char byte: large) sum += (uint8_t)byte;
+        REQUIRE(Checksum::sum32(large) == sum);
+
+        uint8_t sum8 = 0;
+        uint16_t sum16 = 0;
+        uint32_t sum32 = 0;
+        for(qsizetype i = 0; i < large.size(); i += 999){
+            sum8 = Checksum::sum8_addData(sum8, large.mid(i, 999));
+            sum16 = Checksum::sum16_addData(sum16, large.mid(i, 999));
+            sum32 = Checksum::sum32_addData(sum32, large.mid(i, 999));
+        }
+        REQUIRE(sum8 == Checksum::sum8(large));
+        REQUIRE(sum16 == Checksum::sum16(large));
+        REQUIRE(sum32 == Checksum::sum32(large));
+    }
+
+    SECTION("Fletcher16") {
+        REQUIRE(Checksum::fletcher16(QByteArray("abcde", 5)) == 0xC8F0);
+        REQUIRE(Checksum::fletcher16(QByteArray("abcdef", 6)) == 0x2057);
+
+        uint16_t checksum = Checksum::fletcher16_initValue;
+        for(int i = 0; i < large.size(); i += 999){
+            checksum = Checksum::fletcher16_addData(checksum, large.mid(i, 999));
+        }
+        REQUIRE(checksum == Checksum::fletcher16(large));
+    }
+
+    SECTION("Adler32") {
+        REQUIRE(Checksum::adler32(QByteArray("Wikipedia", 9)) == 0x11E60398);
+
+        uint32_t checksum = Checksum::adler32_initValue;
+        for(int i = 0; i < large.size(); i += 999){
+            checksum = Checksum::adler32_addData(checksum, large.mid(i, 999));
+        }
+        REQUIRE(checksum == Checksum::adler32(large));
+    }
+}
@@ -1,5 +1,12 @@
 #include <catch2/catch.hpp>
 #include "../source/crc.h"
+#include <QDir>
+#include <thread>
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 using namespace QuCLib;
 
@@ -14,4 +21,196 @@ TEST_CASE( "Test crc16", "[crc16]" ) {
         QByteArray input = QByteArray("\xFF\xFF\x00\x00\x00\x00\x00\x00", 8);
         REQUIRE(Crc::crc16(input) ==  0x00 );
     }
+
+    SECTION("Batch") {
+        QByteArrayList input;
+        for(int i = 0; i < 11; i++){
+            QByteArray frame;
+            for(int j = 0; j < 12+i*7; j++) frame.append((char)(i*31+j));
+            input.append(frame);
+        }
+
+        QList<uint16_t> output = Crc::crc16(input);
+
+        REQUIRE(output.size() == input.size());
+        for(int i = 0; i < input.size(); i++){
+            REQUIRE(output.at(i) == Crc::crc16(input.at(i)));
+        }
+    }
+}
+
+TEST_CASE( "Test crc32", "[crc32]" ) {
+
+    SECTION("Check value") {
+        QByteArray input = QByteArray("123456789", 9);
+        REQUIRE(Crc::crc32(input) ==  0x340BC6D9 );
+    }
+
+    SECTION("Streaming") {
+        uint32_t crc = Crc::crc32_initValue;
+        crc = Crc::crc32_addData(crc, QByteArray("1234", 4));
+        crc = Crc::crc32_addData(crc, QByteArray("56789", 5));
+        REQUIRE(crc ==  0x340BC6D9 );
+    }
+
+    SECTION("Fill") {
+        QByteArray input = QByteArray("\x01\x02\x03\x04", 4);
+        QByteArray filled = input + QByteArray(1000, '\xFF');
+
+        uint32_t crc = Crc::crc32_addData(Crc::crc32_initValue, input);
+        REQUIRE(Crc::crc32_addFill(crc, 0xFF, 1000) == Crc::crc32(filled));
+        REQUIRE(Crc::crc32_addFill(crc, 0xFF, 0) == crc);
+        REQUIRE(Crc::crc32_addFill(Crc::crc32_initValue, 0x00, 77) == Crc::crc32(QByteArray(77, '\x00')));
+    }
+
+    SECTION("Combine") {
+        QByteArray a = QByteArray("1234", 4);
+        QByteArray b = QByteArray("56789", 5);
+        REQUIRE(Crc::crc32_combine(Crc::crc32(a), Crc::crc32(b), b.size()) == 0x340BC6D9 );
+    }
+}
+
+TEST_CASE( "Test crc32c", "[crc32c]" ) {
+
+    SECTION("Check value") {
+        QByteArray input = QByteArray("123456789", 9);
+        REQUIRE(Crc::crc32c(input) ==  0xE3069283 );
+        REQUIRE(Crc::crc32c(QByteArray()) ==  Crc::crc32c_initValue );
+    }
+
+    SECTION("Large buffer, streaming and combine") {
+        QByteArray input;
+        for(int i = 0; i < 100000; i++) input.append((char)(i*7 + (i>>8)));
+
+        uint32_t crc = Crc::crc32c_initValue;
+        for(int i = 0; i < input.size(); i += 997){
+            crc = Crc::crc32c_addData(crc, input.mid(i, 997));
+        }
+        REQUIRE(crc == Crc::crc32c(input));
+
+        QByteArray a = input.mid(0, 12345);
+        QByteArray b = input.mid(12345);
+        REQUIRE(Crc::crc32c_combine(Crc::crc32c(a), Crc::crc32c(b), b.size()) == Crc::crc32c(input));
+    }
+
+    SECTION("Fill") {
+        QByteArray input = QByteArray("\x01\x02\x03\x04", 4);
+        QByteArray filled = input + QByteArray(1000, '\xFF');
+
+        REQUIRE(Crc::crc32c_addFill(Crc::crc32c(input), 0xFF, 1000) == Crc::crc32c(filled));
+    }
+}
+
+TEST_CASE( "Test crc32 STM32", "[crc32Stm32]" ) {
+
+    SECTION("Single word") {
+        QByteArray input = QByteArray("\x78\x56\x34\x12", 4);
+        REQUIRE(Crc::crc32Stm32(input) ==  0xDF8A8A2B );
+    }
+
+    SECTION("Fill") {
+        QByteArray input = QByteArray("\x78\x56\x34\x12", 4);
+        QByteArray filled = input + QByteArray(64, '\xFF');
+
+        REQUIRE(Crc::crc32Stm32_addFill(Crc::crc32Stm32(input), 0xFF, 64) == Crc::crc32Stm32(filled));
+    }
+}
+
+TEST_CASE( "Test crc of file", "[crcFile]" ) {
+
+    QByteArray content;
+    for(int i = 0; i < 3*1024*1024+5; i++) content.append((char)(i*7 + (i >> 12)));
+
+    SECTION("Mapped file") {
+        QFile file(QDir::tempPath()+"/quclib_test_crc.bin");
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write(content);
+        file.close();
+
+        bool ok = false;
+        REQUIRE(Crc::crc32File(file.fileName(), &ok) == Crc::crc32(content));
+        REQUIRE(ok);
+        REQUIRE(Crc::crc32cFile(file.fileName()) == Crc::crc32c(content));
+        REQUIRE(Crc::crc32Stm32File(file.fileName()) == Crc::crc32Stm32(content));
+        REQUIRE(Crc::crc16File(file.fileName()) == Crc::crc16(content));
+
+        // An open file is left open
+        REQUIRE(file.open(QIODevice::ReadOnly));
+        REQUIRE(Crc::crc32File(file, &ok) == Crc::crc32(content));
+        REQUIRE(ok);
+        REQUIRE(file.isOpen());
+        file.close();
+        QFile::remove(file.fileName());
+
+        Crc::crc32File(QDir::tempPath()+"/quclib_test_does_not_exist.bin", &ok);
+        REQUIRE(!ok);
+    }
+
+    SECTION("Larger than one map window") {
+        // Windows of 4 KiB, the file ends in a partial window and has words across the window borders
+        QByteArray data = content.first(3*4096 + 5);
+        QFile file(QDir::tempPath()+"/quclib_test_crc_windows.bin");
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write(data);
+        file.close();
+
+        qint64 windowSize = Crc::fileMapWindowSize();
+        Crc::setFileMapWindowSize(4096);
+        bool ok = false;
+        uint32_t crc = Crc::crc32File(file.fileName(), &ok);
+        uint32_t crcStm32 = Crc::crc32Stm32File(file.fileName());
+        uint16_t crc16 = Crc::crc16File(file.fileName());
+        Crc::setFileMapWindowSize(windowSize);
+        QFile::remove(file.fileName());
+
+        REQUIRE(ok);
+        REQUIRE(crc == Crc::crc32(data));
+        REQUIRE(crcStm32 == Crc::crc32Stm32(data));
+        REQUIRE(crc16 == Crc::crc16(data));
+        REQUIRE(Crc::fileMapWindowSize() == windowSize);
+    }
+
+#ifdef Q_OS_UNIX
+    SECTION("Pipe read in blocks") {
+        // A pipe can't be mapped, it is read in 1 MiB blocks until the writer closes it
+        QString path = QDir::tempPath()+"/quclib_test_crc.fifo";
+        QFile::remove(path);
+        REQUIRE(mkfifo(path.toLocal8Bit().constData(), 0600) == 0);
+
+        // The writer gives up if the pipe is never opened for reading, so it can always be joined
+        std::thread writer([&](){
+            int pipe = -1;
+            for(int retry = 0; retry < 1000 && pipe < 0; retry++){
+                pipe = ::open(path.toLocal8Bit().constData(), O_WRONLY | O_NONBLOCK);
+                if(pipe < 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            if(pipe < 0) return;
+            fcntl(pipe, F_SETFL, fcntl(pipe, F_GETFL) & ~O_NONBLOCK);
+            for(qsizetype written = 0; written < content.size();){
+                ssize_t count = ::write(pipe, content.constData() + written, content.size() - written);
+                if(count <= 0) break;
+                written += count;
+            }
+            ::close(pipe);
+        });
+
+        QFile file(path);
+        bool opened = file.open(QIODevice::ReadOnly);
+        bool sequential = file.isSequential();
+        bool ok = false;
+        uint32_t crc = 0;
+        if(opened){
+            crc = Crc::crc32File(file, &ok);
+            file.readAll(); // lets the writer finish if the pipe wasn't read to its end
+            file.close();
+        }
+        writer.join();
+        QFile::remove(path);
+
+        REQUIRE(opened);
+        REQUIRE(sequential);
+        REQUIRE(ok);
+        REQUIRE(crc == Crc::crc32(content));
+    }
+#endif
 }
@@ -0,0 +1,94 @@
+#include <catch2/catch.hpp>
+#include "../source/memoryImage.h"
+
+using namespace QuCLib;
+
+TEST_CASE( "Test memory image", "[memoryImage]" ) {
+
+    const MemoryImage::Storage storages[] = {MemoryImage::Storage::Chunks, MemoryImage::Storage::Pages};
+
+    SECTION("Merge on write") {
+        for(MemoryImage::Storage storage: storages){
+            MemoryImage image(storage);
+            image.write(0x1000, QByteArray("\x01\x02\x03\x04", 4));
+            image.write(0x1010, QByteArray("\x11\x12", 2));
+            REQUIRE(image.chunkCount() == 2);
+
+            image.write(0x1004, QByteArray("\x05\x06", 2)); // touches the first chunk
+            REQUIRE(image.chunkCount() == 2);
+            REQUIRE(image.chunks().at(0).data == QByteArray("\x01\x02\x03\x04\x05\x06", 6));
+
+            image.write(0x0FFE, QByteArray(0x13, '\xAA')); // overlaps both chunks
+            REQUIRE(image.chunkCount() == 1);
+            REQUIRE(image.firstAddress() == 0x0FFE);
+            REQUIRE(image.lastAddress() == 0x1011);
+            REQUIRE(image.chunks().at(0).data == QByteArray(0x13, '\xAA') + QByteArray("\x12", 1));
+        }
+    }
+
+    SECTION("Read across gaps") {
+        for(MemoryImage::Storage storage: storages){
+            MemoryImage image(storage);
+            image.write(0x2000, QByteArray("\x01\x02", 2));
+            image.write(0x2004, QByteArray("\x05\x06", 2));
+
+            REQUIRE(image.read(0x1FFF, 8, 0xFF) == QByteArray("\xFF\x01\x02\xFF\xFF\x05\x06\xFF", 8));
+            REQUIRE(image.read(0x2004, 2, 0xFF) == QByteArray("\x05\x06", 2));
+            REQUIRE(image.contains(0x2000, 2));
+            REQUIRE(!image.contains(0x2000, 3));
+        }
+    }
+
+    SECTION("Views") {
+        for(MemoryImage::Storage storage: storages){
+            MemoryImage image(storage);
+            image.write(0x0FF0, QByteArray(0x20, '\x01')); // crosses a page border
+            image.write(0x2000, QByteArray(0x10, '\x02'));
+
+            QByteArrayView data;
+            REQUIRE(image.view(0x2004, 8, data));
+            REQUIRE(data.toByteArray() == QByteArray(8, '\x02'));
+            REQUIRE(!image.view(0x200C, 8, data));
+            REQUIRE(!image.view(0x1FFF, 2, data));
+            REQUIRE(image.view(0x0FF0, 0x20, data) == (storage == MemoryImage::Storage::Chunks));
+        }
+    }
+
+    SECTION("Lookup") {
+        for(MemoryImage::Storage storage: storages){
+            MemoryImage image(storage);
+            for(uint32_t i = 0; i < 1000; i++){
+                image.write(i*0x100, QByteArray(0x10, (char)i));
+            }
+            REQUIRE(image.chunkCount() == 1000);
+
+            MemoryImage::Range range;
+            REQUIRE(image.rangeAt(0x5005, range));
+            REQUIRE(range.minimum == 0x5000);
+            REQUIRE(range.maximum == 0x500F);
+            REQUIRE(!image.rangeAt(0x5010, range));
+
+            REQUIRE(image.overwrite(0x5008, QByteArray("\xAB\xCD", 2)));
+            REQUIRE(!image.overwrite(0x500F, QByteArray("\xAB\xCD", 2)));
+            REQUIRE(image.read(0x5007, 4, 0xFF) == QByteArray("\x50\xAB\xCD\x50", 4));
+        }
+    }
+
+    SECTION("Pages across the address space") {
+        MemoryImage image(MemoryImage::Storage::Pages);
+        image.write(0x00000000, QByteArray(0x20, '\x01'));
+        image.write(0x08000FF0, QByteArray(0x20, '\x02')); // spans two pages
+        image.write(0x1FFF0000, QByteArray(0x10, '\x03'));
+        image.write(0xFFFFFFF0, QByteArray(0x20, '\x04')); // clipped at the end of the address space
+
+        REQUIRE(image.chunkCount() == 4);
+        REQUIRE(image.lastAddress() == 0xFFFFFFFF);
+        REQUIRE(image.read(0x08000FEF, 0x22, 0xFF) == QByteArray(1, '\xFF') + QByteArray(0x20, '\x02') + QByteArray(1, '\xFF'));
+
+        // Pages are shared with the copy until they are written
+        MemoryImage copy = image;
+        copy.overwrite(0x08001000, QByteArray("\xAA", 1));
+        REQUIRE(image.read(0x08001000, 1, 0xFF) == QByteArray("\x02", 1));
+        REQUIRE(copy.read(0x08001000, 1, 0xFF) == QByteArray("\xAA", 1));
+    }
+}